@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in vec3 aOffset;
+layout (location = 4) in vec3 aSize;
+layout (location = 5) in float aLayer;
+
+out vec3 TexCoord;
+out vec3 Normal;
+out vec3 worldPos;
+out vec4 color;
+  
+uniform mat4 world;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+	worldPos = (world * vec4(aOffset + aPos * aSize, 1.0f)).xyz;
+    gl_Position = projection * view * vec4(worldPos, 1.0f);
+    TexCoord = vec3(aTexCoord, aLayer);
+	Normal = aNormal;
+	color = vec4(1, 1, 1, 1);
+} 
\ No newline at end of file
@@ -1,17 +1,19 @@
 #version 330 core
 
-in vec2 TexCoord;
+in vec3 TexCoord;
 in vec3 Normal;
 in vec3 worldPos;
 in vec4 color;
 
 out vec4 FragColor;  
   
-uniform sampler2D texture1;
+uniform sampler2DArray texture1;
 uniform vec3 lightColor;
+uniform vec3 eyePos;
 uniform vec3 fogColor;
 uniform float fade;
 uniform float fogStart;
+uniform float fogEnd;
 
 void main()
 {
@@ -20,6 +22,6 @@ void main()
 	vec3 diff = clamp(dot(Normal, vec3(0.5,0.7,0.5)), 0, 1) * lightColor;
 	vec3 amb = vec3(0.4,0.4,0.4);
 
-	float fog = max(fade, pow(clamp(gl_FragCoord.z * fogStart - (fogStart - 1), 0, 1), 16));
+	float fog = max(fade, smoothstep(fogStart, fogEnd, length(worldPos - eyePos)));
     FragColor = mix(t1 * color * vec4(diff + amb, 1), vec4(fogColor,1), fog);
 }
\ No newline at end of file
@@ -1,10 +1,10 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
+layout (location = 1) in vec3 aTexCoord;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec4 aColor;
 
-out vec2 TexCoord;
+out vec3 TexCoord;
 out vec3 Normal;
 out vec3 worldPos;
 out vec4 color;
@@ -0,0 +1,37 @@
+#include "BlockAllocator.h"
+
+BlockAllocator& BlockAllocator::instance() {
+	static BlockAllocator allocator;
+	return allocator;
+}
+
+BlockType* BlockAllocator::allocate() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (free.empty()) {
+		const int size = chunkSize*chunkSize*chunkSize;
+		slabList.emplace_back(new BlockType[size * arraysPerSlab]);
+		auto slab = slabList.back().get();
+		for (int i = arraysPerSlab - 1; i >= 0; --i) {
+			free.push_back(slab + i * size);
+		}
+	}
+
+	auto blocks = free.back();
+	free.pop_back();
+	return blocks;
+}
+
+void BlockAllocator::release(BlockType* blocks) {
+	std::lock_guard<std::mutex> lock(mutex);
+	free.push_back(blocks);
+}
+
+int BlockAllocator::slabs() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return slabList.size();
+}
+
+int BlockAllocator::freeArrays() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return free.size();
+}
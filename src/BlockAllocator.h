@@ -0,0 +1,30 @@
+#ifndef BlockAllocator_h
+#define BlockAllocator_h
+
+#include "Chunk.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Hands out the block arrays of chunks from large slabs and takes them back, so chunks
+// streaming in and out reuse the same memory instead of going through the heap every time.
+class BlockAllocator {
+public:
+	static BlockAllocator& instance();
+
+	BlockType* allocate();
+	void release(BlockType* blocks);
+
+	int slabs();
+	int freeArrays();
+
+	static const int arraysPerSlab = 32;
+
+private:
+	std::mutex mutex;
+	std::vector<std::unique_ptr<BlockType[]>> slabList;
+	std::vector<BlockType*> free;
+};
+
+#endif
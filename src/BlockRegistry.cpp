@@ -0,0 +1,92 @@
+#include "BlockRegistry.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+BlockProperties BlockRegistry::table[256];
+
+// fills the table before anything can look at it, load() only changes what the file lists
+static bool initialized = (BlockRegistry::reset(), true);
+
+void BlockRegistry::reset() {
+	for (int i = 0; i < 256; ++i) {
+		auto& block = table[i];
+		memset(&block, 0, sizeof(block));
+		memset(block.tiles, i, sizeof(block.tiles));
+		memset(block.tint, 255, sizeof(block.tint));
+		block.flags = i == (int)BlockType::AIR ? 0 : BLOCK_OPAQUE | BLOCK_SOLID;
+	}
+}
+
+// a whole number from min to max and nothing else
+static bool parseValue(const std::string& text, int min, int max, int& value) {
+	if (text.empty()) return false;
+	char* end;
+	long result = strtol(text.c_str(), &end, 10);
+	if (*end != '\0' || result < min || result > max) return false;
+	value = (int)result;
+	return true;
+}
+
+// One block type per line, an id from 0 to 255 followed by its name and any of
+//   transparent passable fluid gravity blastproof explosive light=<0-15> tile=<n> top=<n> bottom=<n> side=<n> tint=<r>,<g>,<b>
+// with tiles and colours from 0 to 255. Empty lines and lines starting with # are skipped,
+// anything else that does not fit makes the whole file fail.
+bool BlockRegistry::load(const std::string& fileName) {
+	std::ifstream file(fileName);
+	if (!file.is_open()) return false;
+
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream words(line);
+		std::string idText;
+		std::string name;
+		if (!(words >> idText) || idText[0] == '#') continue;
+
+		int id;
+		if (!parseValue(idText, 0, 255, id) || !(words >> name)) return false;
+
+		auto& block = table[id];
+		std::string word;
+		while (words >> word) {
+			auto eq = word.find('=');
+			auto key = word.substr(0, eq);
+			auto text = eq == std::string::npos ? std::string() : word.substr(eq + 1);
+			int value = 0;
+
+			if (key == "transparent") block.flags &= ~BLOCK_OPAQUE;
+			else if (key == "passable") block.flags &= ~BLOCK_SOLID;
+			else if (key == "fluid") block.flags |= BLOCK_FLUID;
+			else if (key == "gravity") block.flags |= BLOCK_GRAVITY;
+			else if (key == "blastproof") block.flags |= BLOCK_BLAST_PROOF;
+			else if (key == "explosive") block.flags |= BLOCK_EXPLOSIVE;
+			else if (key == "light") {
+				if (!parseValue(text, 0, 15, value)) return false;
+				block.light = (unsigned char)value;
+			}
+			else if (key == "tile" || key == "top" || key == "bottom" || key == "side") {
+				if (!parseValue(text, 0, 255, value)) return false;
+				if (key == "tile") memset(block.tiles, value, sizeof(block.tiles));
+				else if (key == "top") block.tiles[FACE_TOP] = (unsigned char)value;
+				else if (key == "bottom") block.tiles[FACE_BOTTOM] = (unsigned char)value;
+				else {
+					block.tiles[FACE_LEFT] = block.tiles[FACE_RIGHT] = (unsigned char)value;
+					block.tiles[FACE_BACK] = block.tiles[FACE_FRONT] = (unsigned char)value;
+				}
+			}
+			else if (key == "tint") {
+				std::istringstream parts(text);
+				std::string part;
+				for (int i = 0; i < 3; ++i) {
+					if (!std::getline(parts, part, ',') || !parseValue(part, 0, 255, value)) return false;
+					block.tint[i] = (unsigned char)value;
+				}
+				if (std::getline(parts, part, ',')) return false;
+			}
+			else return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,91 @@
+#ifndef BlockRegistry_h
+#define BlockRegistry_h
+
+#include <string>
+
+enum class BlockType : unsigned char {
+	AIR = 0,
+	STONE,
+	DIRT,
+	GRASS,
+	PLANKS,
+	STEPS,
+	CLAY,
+	BRICKS,
+	TNT,
+	COBBLE = 16,
+	BEDROCK,
+	SAND,
+	GRAVEL,
+	WOOD,
+	GOLD_ORE = 32,
+	IRON_ORE,
+	COAL_ORE,
+	LEAVES = 53,
+	SNOW = 66,
+	WATER = 205
+};
+
+// faces of a block, in the order of the ChunkBorder bits
+enum BlockFace {
+	FACE_LEFT,
+	FACE_RIGHT,
+	FACE_BOTTOM,
+	FACE_TOP,
+	FACE_BACK,
+	FACE_FRONT
+};
+
+enum BlockFlags {
+	// hides the faces of blocks behind it and casts shade
+	BLOCK_OPAQUE = 1,
+	// meshed as water, flows and can be swum in
+	BLOCK_FLUID = 2,
+	// falls when there is nothing solid below
+	BLOCK_GRAVITY = 4,
+	// stops the player, raycasts and falling blocks
+	BLOCK_SOLID = 8,
+	// left standing by explosions
+	BLOCK_BLAST_PROOF = 16,
+	// goes off when clicked or caught in a blast instead of being removed
+	BLOCK_EXPLOSIVE = 32
+};
+
+// What the game needs to know about a block type. One entry is 16 bytes, so the whole table
+// fits in 64 cache lines and four entries share a line.
+struct alignas(16) BlockProperties {
+	// atlas tile of each BlockFace
+	unsigned char tiles[6];
+	unsigned char flags;
+	// light the block gives off itself, 0 to 15
+	unsigned char light;
+	// colour the faces are multiplied with, 255 leaves them as they are
+	unsigned char tint[3];
+	unsigned char padding[5];
+};
+
+static_assert(sizeof(BlockProperties) == 16, "BlockProperties should be 16 bytes");
+
+// Properties of all 256 block types, indexed by BlockType. Every type starts out as an opaque,
+// solid block showing its own atlas tile on all faces, and air as empty. load() overrides them from
+// a text file.
+class BlockRegistry {
+public:
+	static const BlockProperties& get(BlockType type) { return table[(int)type]; }
+
+	static bool load(const std::string& fileName);
+	static void reset();
+
+private:
+	static BlockProperties table[256];
+};
+
+inline bool isSolid(BlockType block, bool isWater) {
+	return isWater ? block != BlockType::AIR : (BlockRegistry::get(block).flags & BLOCK_SOLID) != 0;
+}
+
+inline bool isOpaque(BlockType block) {
+	return (BlockRegistry::get(block).flags & BLOCK_OPAQUE) != 0;
+}
+
+#endif
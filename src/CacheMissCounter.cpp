@@ -0,0 +1,44 @@
+#include "CacheMissCounter.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+CacheMissCounter::CacheMissCounter() {
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+CacheMissCounter::~CacheMissCounter() {
+	if (fd >= 0) close(fd);
+}
+
+void CacheMissCounter::start() {
+	if (fd < 0) return;
+	ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+	ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+long long CacheMissCounter::stop() {
+	if (fd < 0) return 0;
+	ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	long long count = 0;
+	if (read(fd, &count, sizeof(count)) != sizeof(count)) return 0;
+	return count;
+}
+#else
+CacheMissCounter::CacheMissCounter() {}
+CacheMissCounter::~CacheMissCounter() {}
+void CacheMissCounter::start() {}
+long long CacheMissCounter::stop() { return 0; }
+#endif
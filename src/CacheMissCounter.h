@@ -0,0 +1,21 @@
+#ifndef CacheMissCounter_h
+#define CacheMissCounter_h
+
+// Hardware cache misses of the calling thread, counted with perf_event_open on Linux. Elsewhere,
+// or when the kernel does not allow it, available() is false and stop() returns 0.
+class CacheMissCounter {
+public:
+	CacheMissCounter();
+	~CacheMissCounter();
+
+	void start();
+	// misses since start()
+	long long stop();
+
+	bool available() const { return fd >= 0; }
+
+private:
+	int fd = -1;
+};
+
+#endif
@@ -2,21 +2,21 @@
 #include "ChunkGenerator.h"
 #include "Model.h"
 #include "GLMesh.h"
+#include "BlockAllocator.h"
+#include "ChunkView.h"
 
 #include <sstream>
 #include <fstream>
 #include <iomanip>
 #include <thread>
-
-BlockType getBlockAt(int x, int y, int z);
+#include <mutex>
+#include <cstring>
 
 Chunk::Chunk(int x, int y, int z) : gridx(x), gridy(y), gridz(z) {
 }
 
 Chunk::~Chunk() {
-	if (blocks) {
-		delete[] blocks;
-	}
+	releaseBlocks();
 	if (model) {
 		delete model;
 	}
@@ -25,21 +25,73 @@ Chunk::~Chunk() {
 	}
 }
 
+void Chunk::reset(int x, int y, int z) {
+	releaseBlocks();
+	gridx = x;
+	gridy = y;
+	gridz = z;
+	isEmpty = true;
+	isNew = true;
+	isDirty = true;
+	lod = 0;
+	lastUsed = 0;
+	liveBlocks.clear();
+
+	for (auto m : { model, waterModel }) {
+		if (m) {
+			m->position = Vector3(gridx*chunkSize, gridy*chunkSize, gridz*chunkSize);
+			m->fade = 1.0f;
+		}
+	}
+}
+
+void Chunk::releaseBlocks() {
+	if (blocks && !sharedBlocks) {
+		BlockAllocator::instance().release(blocks);
+	}
+	blocks = nullptr;
+	sharedBlocks = false;
+	for (int i = 0; i < maxLod; ++i) {
+		mipsValid[i] = false;
+	}
+}
+
 Chunk* getChunk(int gridx, int gridy, int gridz);
 
 void Chunk::generateBlocks(ChunkGenerator* gen) {
-	gen->init(gridx*chunkSize, gridz*chunkSize);
-	if (!blocks) {
-		blocks = new BlockType[chunkSize*chunkSize*chunkSize];
+	auto column = gen->getColumn(gridx, gridz);
+
+	// most chunks lie entirely above the terrain and are nothing but air or water
+	BlockType uniform;
+	if (gen->isUniform(*column, gridy, uniform)) {
+		setUniform(uniform);
 	}
-	for (int y = 0; y < chunkSize; ++y) {
-		for (int z = 0; z < chunkSize; ++z) {
-			for (int x = 0; x < chunkSize; ++x) {
-				auto block = gen->getBlockAt(gridx*chunkSize + x, gridy*chunkSize + y, gridz*chunkSize + z);
-				if (block == BlockType::WOOD) {
-					liveBlocks.push_back(DynamicBlock{ x, y, z, 17 + rand() % 17 });
+	else {
+#if CHUNK_LAYOUT == CHUNK_LAYOUT_LINEAR
+		gen->generate(*column, gridy, ownBlocks());
+#else
+		// the stages write rows in linear order, copy them into the chunk's layout
+		static thread_local BlockType generated[chunkSize*chunkSize*chunkSize];
+		gen->generate(*column, gridy, generated);
+		for (int y = 0; y < chunkSize; ++y) {
+			for (int z = 0; z < chunkSize; ++z) {
+				writeRow(0, y, z, chunkSize, generated + (y * chunkSize + z) * chunkSize);
+			}
+		}
+#endif
+	}
+
+	// structures of loaded neighbours reaching into this chunk, and the parts of this
+	// chunk's structures reaching into neighbours that are already loaded
+	gen->pending.apply(this);
+	int r = gen->neighbourRadius();
+	for (int y = gridy - r; y <= gridy + r; ++y) {
+		for (int z = gridz - r; z <= gridz + r; ++z) {
+			for (int x = gridx - r; x <= gridx + r; ++x) {
+				auto chunk = getChunk(x, y, z);
+				if (chunk && chunk != this) {
+					gen->pending.apply(chunk, gridx, gridy, gridz);
 				}
-				blocks[y * chunkSize*chunkSize + z * chunkSize + x] = block;
 			}
 		}
 	}
@@ -60,15 +112,48 @@ void Chunk::generateBlocks(ChunkGenerator* gen) {
 	}*/
 }
 
-bool isSolid(BlockType block, bool isWater) {
-	return isWater ? block != BlockType::AIR : block != BlockType::AIR && block != BlockType::WATER;
+static BlockType* uniformBlocks(BlockType type) {
+	static std::mutex mutex;
+	static BlockType* arrays[256] = {};
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& array = arrays[(int)type];
+	if (!array) {
+		array = new BlockType[chunkSize*chunkSize*chunkSize];
+		memset(array, (int)type, chunkSize*chunkSize*chunkSize);
+	}
+	return array;
+}
+
+void Chunk::setUniform(BlockType type) {
+	releaseBlocks();
+	blocks = uniformBlocks(type);
+	sharedBlocks = true;
+}
+
+BlockType* Chunk::ownBlocks() {
+	// the caller is about to change blocks
+	for (int i = 0; i < maxLod; ++i) {
+		mipsValid[i] = false;
+	}
+
+	if (!blocks) {
+		blocks = BlockAllocator::instance().allocate();
+	}
+	else if (sharedBlocks) {
+		auto shared = blocks;
+		blocks = BlockAllocator::instance().allocate();
+		memcpy(blocks, shared, chunkSize*chunkSize*chunkSize);
+	}
+	sharedBlocks = false;
+	return blocks;
 }
 
 BlockType Chunk::getBlockAt(int x, int y, int z) {
 	if (x < 0 || y < 0 || z < 0 || x > chunkSize - 1 || y > chunkSize - 1 || z > chunkSize - 1) {
 		return BlockType::AIR;
 	}
-	return blocks[y * chunkSize*chunkSize + z * chunkSize + x];
+	return blocks[index(x, y, z)];
 }
 
 void Chunk::setBlockAt(int x, int y, int z, BlockType type) {
@@ -76,43 +161,115 @@ void Chunk::setBlockAt(int x, int y, int z, BlockType type) {
 		return;
 	}
 	if (getBlockAt(x, y, z) == type) return;
-	blocks[y * chunkSize*chunkSize + z * chunkSize + x] = type;
+	ownBlocks()[index(x, y, z)] = type;
+	markDirty(bordersOf(x, y, z));
+}
+
+const BlockType* Chunk::getCells(int step) {
+	int level = 0;
+	while ((2 << level) < step) ++level;
+	return getMip(level);
+}
+
+// Each cell of a mip level covers 2x2x2 cells of the level below. It is empty unless at least
+// half of them are filled, and then takes the type of the highest filled one, so grass stays on top.
+const BlockType* Chunk::getMip(int level) {
+	auto& mip = mips[level];
+	if (mipsValid[level]) {
+		return mip.data();
+	}
+
+	// level 0 is built from blocks, in whatever layout they are
+	const BlockType* source = level == 0 ? nullptr : getMip(level - 1);
+	int sourceSize = chunkSize >> level;
+	int size = sourceSize / 2;
+	mip.resize(size*size*size);
+
+	for (int y = 0; y < size; ++y) {
+		for (int z = 0; z < size; ++z) {
+			for (int x = 0; x < size; ++x) {
+				int filled = 0;
+				BlockType top = BlockType::AIR;
+				for (int dy = 1; dy >= 0; --dy) {
+					for (int dz = 0; dz < 2; ++dz) {
+						for (int dx = 0; dx < 2; ++dx) {
+							int sx = x * 2 + dx, sy = y * 2 + dy, sz = z * 2 + dz;
+							auto block = source ? source[sy * sourceSize*sourceSize + sz * sourceSize + sx] : blocks[index(sx, sy, sz)];
+							if (block == BlockType::AIR) continue;
+							if (top == BlockType::AIR) top = block;
+							++filled;
+						}
+					}
+				}
+				mip[y * size*size + z * size + x] = filled >= 4 ? top : BlockType::AIR;
+			}
+		}
+	}
+
+	mipsValid[level] = true;
+	return mip.data();
+}
+
+const char* Chunk::layoutName() {
+#if CHUNK_LAYOUT == CHUNK_LAYOUT_MORTON
+	return "morton";
+#elif CHUNK_LAYOUT == CHUNK_LAYOUT_TILED
+	return "tiled";
+#else
+	return "linear";
+#endif
+}
+
+int Chunk::bordersOf(int x, int y, int z) {
+	int borders = 0;
+	if (x == 0) borders |= BORDER_LEFT;
+	if (x == chunkSize - 1) borders |= BORDER_RIGHT;
+	if (y == 0) borders |= BORDER_BOTTOM;
+	if (y == chunkSize - 1) borders |= BORDER_TOP;
+	if (z == 0) borders |= BORDER_BACK;
+	if (z == chunkSize - 1) borders |= BORDER_FRONT;
+	return borders;
+}
+
+void Chunk::markDirty(int borders) {
 	isDirty = true;
-	if (x == 0) {
+	if (borders & BORDER_LEFT) {
 		auto chunk = getChunk(gridx - 1, gridy, gridz);
 		if (chunk) chunk->isDirty = true;
 	}
-	if (y == 0) {
+	if (borders & BORDER_BOTTOM) {
 		auto chunk = getChunk(gridx, gridy - 1, gridz);
 		if (chunk) chunk->isDirty = true;
 	}
-	if (z == 0) {
+	if (borders & BORDER_BACK) {
 		auto chunk = getChunk(gridx, gridy, gridz - 1);
 		if (chunk) chunk->isDirty = true;
 	}
-	if (x == chunkSize - 1) {
+	if (borders & BORDER_RIGHT) {
 		auto chunk = getChunk(gridx + 1, gridy, gridz);
 		if (chunk) chunk->isDirty = true;
 	}
-	if (y == chunkSize - 1) {
+	if (borders & BORDER_TOP) {
 		auto chunk = getChunk(gridx, gridy + 1, gridz);
 		if (chunk) chunk->isDirty = true;
 	}
-	if (z == chunkSize - 1) {
+	if (borders & BORDER_FRONT) {
 		auto chunk = getChunk(gridx, gridy, gridz + 1);
 		if (chunk) chunk->isDirty = true;
 	}
 }
 
-Vector4 Chunk::calcLight(int x, int y, int z, int dx, int dy, int dz) {
+Vector4 Chunk::calcLight(const PaddedView& view, int x, int y, int z, int dx, int dy, int dz) {
+	// not worth the lookups on distant chunks
+	if (lod > 0) {
+		return Vector4(1, 1, 1, 1);
+	}
+
 	int num = 0;
-	int sx = gridx*chunkSize;
-	int sy = gridy*chunkSize;
-	int sz = gridz*chunkSize;
 	for (int i = 0; i < dx; ++i) {
 		for (int j = 0; j < dy; ++j) {
 			for (int k = 0; k < dz; ++k) {
-				if (!isSolid(::getBlockAt(sx + x + i, sy + y + j, sz + z + k), false)) {
+				if (!isOpaque(view.at(x + i, y + j, z + k))) {
 					++num;
 				}
 			}
@@ -122,6 +279,16 @@ Vector4 Chunk::calcLight(int x, int y, int z, int dx, int dy, int dz) {
 	return Vector4(l, l, l, 1);
 }
 
+GLMesh* Chunk::createMesh() {
+	static_assert(sizeof(Vertex) == 13 * sizeof(float), "the mesh attributes have to match Chunk::Vertex");
+	return new GLMesh({
+		{ 3, GL_FLOAT, sizeof(float) },
+		{ 3, GL_FLOAT, sizeof(float) },
+		{ 3, GL_FLOAT, sizeof(float) },
+		{ 4, GL_FLOAT, sizeof(float) },
+	});
+}
+
 void Chunk::generateModel() {
 	isDirty = false;
 
@@ -130,12 +297,7 @@ void Chunk::generateModel() {
 		model->position = Vector3(gridx*chunkSize, gridy*chunkSize, gridz*chunkSize);
 		model->rotation = Quaternion::identity;
 		model->material = chunkMaterial;
-		model->mesh = new GLMesh({
-			{ 3, GL_FLOAT, sizeof(float)},
-			{ 2, GL_FLOAT, sizeof(float) },
-			{ 3, GL_FLOAT, sizeof(float) },
-			{ 4, GL_FLOAT, sizeof(float) },
-		});
+		model->mesh = createMesh();
 	}
 
 	if (!waterModel) {
@@ -143,12 +305,7 @@ void Chunk::generateModel() {
 		waterModel->position = Vector3(gridx*chunkSize, gridy*chunkSize, gridz*chunkSize);
 		waterModel->rotation = Quaternion::identity;
 		waterModel->material = waterMaterial;
-		waterModel->mesh = new GLMesh({
-			{ 3, GL_FLOAT, sizeof(float) },
-			{ 2, GL_FLOAT, sizeof(float) },
-			{ 3, GL_FLOAT, sizeof(float) },
-			{ 4, GL_FLOAT, sizeof(float) },
-		});
+		waterModel->mesh = createMesh();
 	}
 
 	static std::vector<Vertex> chunkVertices;
@@ -156,37 +313,95 @@ void Chunk::generateModel() {
 	chunkVertices.clear();
 	waterVertices.clear();
 
-	auto leftChunk = getChunk(gridx - 1, gridy, gridz);
-	auto rightChunk = getChunk(gridx + 1, gridy, gridz);
-	auto topChunk = getChunk(gridx, gridy + 1, gridz);
-	auto bottomChunk = getChunk(gridx, gridy - 1, gridz);
-	auto frontChunk = getChunk(gridx, gridy, gridz + 1);
-	auto backChunk = getChunk(gridx, gridy, gridz - 1);
-
-	int step = 1;
-
-	for (int y = 0; y < chunkSize; y += step) {
-		for (int z = 0; z < chunkSize; z += step) {
-			for (int x = 0; x < chunkSize; x += step) {
-				auto block = getBlockAt(x, y, z);
-				bool isWater = block == BlockType::WATER;
-				if (block == BlockType::AIR) {
-					continue;
-				}
+	int step = 1 << lod;
+
+	// the cells of this chunk and a border of its neighbours, at this chunk's level of detail
+	ChunkNeighbours neighbours(this);
+	static PaddedView view;
+	view.build(neighbours, step);
+	int size = view.size;
+
+	// Faces towards a missing neighbour are left out until it is loaded. Faces towards a neighbour
+	// meshed at another level of detail are kept even if the neighbour is solid there. They hang
+	// down the border like a skirt and hide the cracks between the levels.
+	int missing = 0;
+	int skirts = 0;
+	const int sides[6][4] = {
+		{ -1, 0, 0, BORDER_LEFT }, { 1, 0, 0, BORDER_RIGHT },
+		{ 0, -1, 0, BORDER_BOTTOM }, { 0, 1, 0, BORDER_TOP },
+		{ 0, 0, -1, BORDER_BACK }, { 0, 0, 1, BORDER_FRONT },
+	};
+	for (auto& side : sides) {
+		auto chunk = neighbours.at(side[0], side[1], side[2]);
+		if (!chunk) missing |= side[3];
+		else if (chunk->lod != lod) skirts |= side[3];
+	}
 
-				bool renderBottom = y == 0 ? (bottomChunk ? !isSolid(bottomChunk->getBlockAt(x, chunkSize - step, z), isWater) : false) : !isSolid(getBlockAt(x, y - step, z), isWater);
-				bool renderTop = y == chunkSize - step ? (topChunk ? !isSolid(topChunk->getBlockAt(x, 0, z), isWater) : false) : !isSolid(getBlockAt(x, y + step, z), isWater);
+	// a shared all-air chunk has no faces at all
+	int height = isUniform(BlockType::AIR) ? 0 : size;
+
+	// Visibility is worked out a whole row of cells at a time from the view's row masks. Bit
+	// cx + 1 of a mask stands for cell cx, bits 0 and size + 1 for the cells of the neighbours.
+	const std::uint64_t inside = ((1ull << size) - 1) << 1;
+	const std::uint64_t first = 1ull << 1;
+	const std::uint64_t last = 1ull << size;
+
+	for (int cy = 0; cy < height; ++cy) {
+		for (int cz = 0; cz < size; ++cz) {
+			std::uint64_t opaque = view.opaqueRow(cy, cz) & inside;
+			// water and other blocks that can be seen through
+			std::uint64_t clear = view.filledRow(cy, cz) & ~opaque & inside;
+			if (!(opaque | clear)) continue;
+
+			// clear cells only hide behind filled cells, opaque ones behind opaque ones
+			auto faces = [&](std::uint64_t opaqueNeighbours, std::uint64_t filledNeighbours) {
+				return (opaque & ~opaqueNeighbours) | (clear & ~filledNeighbours);
+			};
+			std::uint64_t left = faces(view.opaqueRow(cy, cz) << 1, view.filledRow(cy, cz) << 1);
+			std::uint64_t right = faces(view.opaqueRow(cy, cz) >> 1, view.filledRow(cy, cz) >> 1);
+			std::uint64_t bottom = faces(view.opaqueRow(cy - 1, cz), view.filledRow(cy - 1, cz));
+			std::uint64_t top = faces(view.opaqueRow(cy + 1, cz), view.filledRow(cy + 1, cz));
+			std::uint64_t back = faces(view.opaqueRow(cy, cz - 1), view.filledRow(cy, cz - 1));
+			std::uint64_t front = faces(view.opaqueRow(cy, cz + 1), view.filledRow(cy, cz + 1));
+
+			if (missing | skirts) {
+				auto border = [&](std::uint64_t& sideFaces, int side, std::uint64_t cells) {
+					if (missing & side) sideFaces &= ~cells;
+					if (skirts & side) sideFaces |= opaque & cells;
+				};
+				border(left, BORDER_LEFT, first);
+				border(right, BORDER_RIGHT, last);
+				if (cy == 0) border(bottom, BORDER_BOTTOM, inside);
+				if (cy == size - 1) border(top, BORDER_TOP, inside);
+				if (cz == 0) border(back, BORDER_BACK, inside);
+				if (cz == size - 1) border(front, BORDER_FRONT, inside);
+			}
 
-				bool renderLeft = x == 0 ? (leftChunk ? !isSolid(leftChunk->getBlockAt(chunkSize - step, y, z), isWater) : false) : !isSolid(getBlockAt(x - step, y, z), isWater);
-				bool renderRight = x == chunkSize - step ? (rightChunk ? !isSolid(rightChunk->getBlockAt(0, y, z), isWater) : false) : !isSolid(getBlockAt(x + step, y, z), isWater);
+			for (auto visible = left | right | bottom | top | back | front; visible; visible &= visible - 1) {
+				int bit = countTrailingZeros(visible);
+				std::uint64_t mask = 1ull << bit;
+				int cx = bit - 1;
+				auto block = view.at(cx, cy, cz);
+				auto& props = BlockRegistry::get(block);
+				bool isWater = (props.flags & BLOCK_FLUID) != 0;
 
-				bool renderBack = z == 0 ? (backChunk ? !isSolid(backChunk->getBlockAt(x, y, chunkSize - step), isWater) : false) : !isSolid(getBlockAt(x, y, z - step), isWater);
-				bool renderFront = z == chunkSize - step ? (frontChunk ? !isSolid(frontChunk->getBlockAt(x, y, 0), isWater) : false) : !isSolid(getBlockAt(x, y, z + step), isWater);
+				int x = cx * step;
+				int y = cy * step;
+				int z = cz * step;
 
-				if (!(renderTop || renderBottom || renderFront || renderBack || renderLeft || renderRight)) continue;
+				bool renderBottom = (bottom & mask) != 0;
+				bool renderTop = (top & mask) != 0;
 
-				auto uv = Vector2(1.0f / 16 * ((int)block % 16), 1.0f - 1.0f / 16 * (1 + (int)block / 16));
-				auto uvtop(uv);
+				bool renderLeft = (left & mask) != 0;
+				bool renderRight = (right & mask) != 0;
+
+				bool renderBack = (back & mask) != 0;
+				bool renderFront = (front & mask) != 0;
+
+				// the texture repeats once per block across the coarser cells
+				Vector3 uv;
+				Vector3 uvtop;
+				float s = step;
 
 				auto& vertices = isWater ? waterVertices : chunkVertices;
 
@@ -194,14 +409,22 @@ void Chunk::generateModel() {
 				Vector4 light(1, 1, 1, 1);
 				Vector4 dark(0.5, 0.5, 0.5, 1);
 
-				Vector4 color = block == BlockType::LEAVES ? Vector4(0, 0.8, 0, 1) : Vector4::white;
+				Vector4 color(props.tint[0] / 255.0f, props.tint[1] / 255.0f, props.tint[2] / 255.0f, 1);
+
+				// blocks giving off light are never shaded darker than their own light
+				float glow = props.light / 15.0f;
+				auto shade = [&](int x, int y, int z, int dx, int dy, int dz) {
+					auto l = calcLight(view, x, y, z, dx, dy, dz);
+					if (l.x < glow) l = Vector4(glow, glow, glow, 1);
+					return color * l;
+				};
 
 				// top
 				if (renderTop) {
-					if (block == BlockType::GRASS) uvtop = Vector2(0, 1.0f - 1.0f / 16);
+					uvtop = Vector3(0, 0, props.tiles[FACE_TOP]);
 
 					for (int c = step; c < 16; c += step) {
-						if (isSolid(::getBlockAt(gridx*chunkSize + x, gridy*chunkSize + y + c, gridz*chunkSize + z), false)) {
+						if (isOpaque(view.at(cx, cy + c / step, cz))) {
 							color.r *= (0.5f + float(c) / 32);
 							color.g *= (0.5f + float(c) / 32);
 							color.b *= (0.5f + float(c) / 32);
@@ -209,51 +432,55 @@ void Chunk::generateModel() {
 						}
 					}
 
-					vertices.push_back({ Vector3(x, y + h, z), uvtop + Vector2(0,0), Vector3::up, color * calcLight(x - 1 ,y + 1,z - 1, 2, 1, 2) });
-					vertices.push_back({ Vector3(x, y + h, z + step), uvtop + Vector2(0,1.0f / 16), Vector3::up,  color * calcLight(x - 1,y + 1,z, 2, 1, 2) });
-					vertices.push_back({ Vector3(x + step, y + h, z + step), uvtop + Vector2(1.0f / 16,1.0f / 16), Vector3::up,  color * calcLight(x,y + 1,z, 2, 1, 2) });
-					vertices.push_back({ Vector3(x + step, y + h, z), uvtop + Vector2(1.0f / 16,0), Vector3::up,  color * calcLight(x,y + 1,z - 1, 2, 1, 2) });
+					vertices.push_back({ Vector3(x, y + h, z), uvtop + Vector3(0, 0, 0), Vector3::up, shade(x - 1 ,y + 1,z - 1, 2, 1, 2) });
+					vertices.push_back({ Vector3(x, y + h, z + step), uvtop + Vector3(0, s, 0), Vector3::up,  shade(x - 1,y + 1,z, 2, 1, 2) });
+					vertices.push_back({ Vector3(x + step, y + h, z + step), uvtop + Vector3(s, s, 0), Vector3::up,  shade(x,y + 1,z, 2, 1, 2) });
+					vertices.push_back({ Vector3(x + step, y + h, z), uvtop + Vector3(s, 0, 0), Vector3::up,  shade(x,y + 1,z - 1, 2, 1, 2) });
 				}
 
 				// bottom
 				if (renderBottom) {
-					if (block == BlockType::GRASS) uvtop = Vector2(2.0f / 16, 1.0f - 1.0f / 16);
-					vertices.push_back({ Vector3(x + step, y, z), uvtop + Vector2(1.0f / 16,0), Vector3::down, color * calcLight(x ,y - 1,z - 1, 2, 1, 2) });
-					vertices.push_back({ Vector3(x + step, y, z + step), uvtop + Vector2(1.0f / 16,1.0f / 16), Vector3::down, color * calcLight(x,y - 1,z, 2, 1, 2) });
-					vertices.push_back({ Vector3(x, y, z + step), uvtop + Vector2(0,1.0f / 16), Vector3::down, color * calcLight(x - 1,y - 1,z, 2, 1, 2) });
-					vertices.push_back({ Vector3(x, y, z), uvtop + Vector2(0,0), Vector3::down, color * calcLight(x - 1,y - 1,z - 1, 2, 1, 2) });
+					uvtop = Vector3(0, 0, props.tiles[FACE_BOTTOM]);
+					vertices.push_back({ Vector3(x + step, y, z), uvtop + Vector3(s, 0, 0), Vector3::down, shade(x ,y - 1,z - 1, 2, 1, 2) });
+					vertices.push_back({ Vector3(x + step, y, z + step), uvtop + Vector3(s, s, 0), Vector3::down, shade(x,y - 1,z, 2, 1, 2) });
+					vertices.push_back({ Vector3(x, y, z + step), uvtop + Vector3(0, s, 0), Vector3::down, shade(x - 1,y - 1,z, 2, 1, 2) });
+					vertices.push_back({ Vector3(x, y, z), uvtop + Vector3(0, 0, 0), Vector3::down, shade(x - 1,y - 1,z - 1, 2, 1, 2) });
 				}
 
 				// front
 				if (renderFront) {
-					vertices.push_back({ Vector3(x, y, z + step), uv + Vector2(0,0), Vector3::backward, color * calcLight(x - 1,y - 1,z + 1, 2, 2, 1) });
-					vertices.push_back({ Vector3(x + step, y, z + step), uv + Vector2(1.0f / 16,0), Vector3::backward, color * calcLight(x,y - 1,z + 1, 2, 2, 1) });
-					vertices.push_back({ Vector3(x + step, y + h, z + step), uv + Vector2(1.0f / 16,1.0f / 16), Vector3::backward, color * calcLight(x,y,z + 1, 2, 2, 1) });
-					vertices.push_back({ Vector3(x, y + h, z + step), uv + Vector2(0, 1.0f / 16), Vector3::backward, color * calcLight(x - 1,y,z + 1, 2, 2, 1) });
+					uv = Vector3(0, 0, props.tiles[FACE_FRONT]);
+					vertices.push_back({ Vector3(x, y, z + step), uv + Vector3(0, 0, 0), Vector3::backward, shade(x - 1,y - 1,z + 1, 2, 2, 1) });
+					vertices.push_back({ Vector3(x + step, y, z + step), uv + Vector3(s, 0, 0), Vector3::backward, shade(x,y - 1,z + 1, 2, 2, 1) });
+					vertices.push_back({ Vector3(x + step, y + h, z + step), uv + Vector3(s, s, 0), Vector3::backward, shade(x,y,z + 1, 2, 2, 1) });
+					vertices.push_back({ Vector3(x, y + h, z + step), uv + Vector3(0, s, 0), Vector3::backward, shade(x - 1,y,z + 1, 2, 2, 1) });
 				}
 
 				// back
 				if (renderBack) {
-					vertices.push_back({ Vector3(x, y + h, z), uv + Vector2(0, 1.0f / 16), Vector3::forward, color * calcLight(x - 1,y,z - 1, 2, 2, 1) });
-					vertices.push_back({ Vector3(x + step, y + h, z), uv + Vector2(1.0f / 16,1.0f / 16), Vector3::forward, color * calcLight(x,y,z - 1, 2, 2, 1) });
-					vertices.push_back({ Vector3(x + step, y, z), uv + Vector2(1.0f / 16,0), Vector3::forward, color * calcLight(x ,y - 1,z - 1, 2, 2, 1) });
-					vertices.push_back({ Vector3(x, y, z), uv + Vector2(0,0), Vector3::forward, color * calcLight(x - 1,y - 1,z - 1, 2, 2, 1) });
+					uv = Vector3(0, 0, props.tiles[FACE_BACK]);
+					vertices.push_back({ Vector3(x, y + h, z), uv + Vector3(0, s, 0), Vector3::forward, shade(x - 1,y,z - 1, 2, 2, 1) });
+					vertices.push_back({ Vector3(x + step, y + h, z), uv + Vector3(s, s, 0), Vector3::forward, shade(x,y,z - 1, 2, 2, 1) });
+					vertices.push_back({ Vector3(x + step, y, z), uv + Vector3(s, 0, 0), Vector3::forward, shade(x ,y - 1,z - 1, 2, 2, 1) });
+					vertices.push_back({ Vector3(x, y, z), uv + Vector3(0, 0, 0), Vector3::forward, shade(x - 1,y - 1,z - 1, 2, 2, 1) });
 				}
 
 				// right
 				if (renderRight) {
-					vertices.push_back({ Vector3(x + step, y, z), uv + Vector2(0,0), Vector3::right, color * calcLight(x + 1,y - 1,z - 1, 1, 2, 2) });
-					vertices.push_back({ Vector3(x + step, y + h, z), uv + Vector2(0,1.0f / 16), Vector3::right, color * calcLight(x + 1,y,z - 1, 1, 2, 2) });
-					vertices.push_back({ Vector3(x + step, y + h, z + step), uv + Vector2(1.0f / 16,1.0f / 16), Vector3::right, color * calcLight(x + 1,y,z, 1, 2, 2) });
-					vertices.push_back({ Vector3(x + step, y, z + step), uv + Vector2(1.0f / 16,0), Vector3::right, color * calcLight(x + 1,y - 1,z, 1, 2, 2) });
+					uv = Vector3(0, 0, props.tiles[FACE_RIGHT]);
+					vertices.push_back({ Vector3(x + step, y, z), uv + Vector3(0, 0, 0), Vector3::right, shade(x + 1,y - 1,z - 1, 1, 2, 2) });
+					vertices.push_back({ Vector3(x + step, y + h, z), uv + Vector3(0, s, 0), Vector3::right, shade(x + 1,y,z - 1, 1, 2, 2) });
+					vertices.push_back({ Vector3(x + step, y + h, z + step), uv + Vector3(s, s, 0), Vector3::right, shade(x + 1,y,z, 1, 2, 2) });
+					vertices.push_back({ Vector3(x + step, y, z + step), uv + Vector3(s, 0, 0), Vector3::right, shade(x + 1,y - 1,z, 1, 2, 2) });
 				}
 
 				// left
 				if (renderLeft) {
-					vertices.push_back({ Vector3(x, y, z + step), uv + Vector2(0, 0), Vector3::left, color * calcLight(x - 1,y - 1,z, 1, 2, 2) });
-					vertices.push_back({ Vector3(x, y + h, z + step), uv + Vector2(0, 1.0f / 16), Vector3::left, color * calcLight(x - 1,y ,z, 1, 2, 2) });
-					vertices.push_back({ Vector3(x, y + h, z), uv + Vector2(1.0f / 16, 1.0f / 16), Vector3::left, color * calcLight(x - 1,y ,z - 1, 1, 2, 2) });
-					vertices.push_back({ Vector3(x, y, z), uv + Vector2(1.0f / 16,0), Vector3::left, color * calcLight(x - 1,y - 1,z - 1, 1, 2, 2) });
+					uv = Vector3(0, 0, props.tiles[FACE_LEFT]);
+					vertices.push_back({ Vector3(x, y, z + step), uv + Vector3(0, 0, 0), Vector3::left, shade(x - 1,y - 1,z, 1, 2, 2) });
+					vertices.push_back({ Vector3(x, y + h, z + step), uv + Vector3(0, s, 0), Vector3::left, shade(x - 1,y ,z, 1, 2, 2) });
+					vertices.push_back({ Vector3(x, y + h, z), uv + Vector3(s, s, 0), Vector3::left, shade(x - 1,y ,z - 1, 1, 2, 2) });
+					vertices.push_back({ Vector3(x, y, z), uv + Vector3(s, 0, 0), Vector3::left, shade(x - 1,y - 1,z - 1, 1, 2, 2) });
 				}
 			}
 		}
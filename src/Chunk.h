@@ -2,35 +2,47 @@
 #define Chunk_h
 
 #include "lina.h"
+#include "BlockRegistry.h"
 #include <vector>
+#include <cstring>
 class Model;
+class GLMesh;
 class ChunkGenerator;
+class PaddedView;
 class Material;
 
-enum class BlockType : unsigned char {
-	AIR = 0,
-	STONE,
-	DIRT,
-	GRASS,
-	PLANKS,
-	STEPS,
-	CLAY,
-	BRICKS,
-	TNT,
-	COBBLE = 16,
-	BEDROCK,
-	SAND,
-	GRAVEL,
-	WOOD,
-	GOLD_ORE = 32,
-	IRON_ORE,
-	COAL_ORE,
-	LEAVES = 53,
-	SNOW = 66,
-	WATER = 205
-};
-
 const int chunkSize = 32;
+const int chunkShift = 5;
+const int chunkMask = chunkSize - 1;
+static_assert(chunkSize == 1 << chunkShift, "chunkSize must be a power of two");
+
+typedef IVec3 ChunkCoord;
+
+// chunk holding a world block coordinate, the arithmetic shift rounds negative coordinates down
+inline int chunkOf(int v) { return v >> chunkShift; }
+inline ChunkCoord chunkOf(int x, int y, int z) { return ChunkCoord(x >> chunkShift, y >> chunkShift, z >> chunkShift); }
+// position of a world block coordinate inside its chunk
+inline IVec3 blockInChunk(int x, int y, int z) { return IVec3(x & chunkMask, y & chunkMask, z & chunkMask); }
+
+// Order of the blocks inside Chunk::blocks, picked at compile time with -DCHUNK_LAYOUT=...
+// Code outside Chunk goes through Chunk::index() or the row helpers and works with all of them.
+#define CHUNK_LAYOUT_LINEAR 0	// rows along x, then z, then y
+#define CHUNK_LAYOUT_MORTON 1	// bits of x, z and y interleaved
+#define CHUNK_LAYOUT_TILED 2	// 4x4x4 bricks, linear inside each brick and between bricks
+#ifndef CHUNK_LAYOUT
+#define CHUNK_LAYOUT CHUNK_LAYOUT_LINEAR
+#endif
+
+// chunk faces, used to tell which neighbours an edit has to remesh
+enum ChunkBorder {
+	BORDER_LEFT = 1,
+	BORDER_RIGHT = 2,
+	BORDER_BOTTOM = 4,
+	BORDER_TOP = 8,
+	BORDER_BACK = 16,
+	BORDER_FRONT = 32,
+	BORDER_ALL = 63
+};
 
 class DynamicBlock {
 public:
@@ -45,6 +57,10 @@ public:
 	Chunk(int x, int y, int z);
 	~Chunk();
 
+	// turns an unloaded chunk into a fresh one at another position, keeping its models
+	void reset(int x, int y, int z);
+	void releaseBlocks();
+
 	void generateBlocks(ChunkGenerator* gen);
 	void generateModel();
 
@@ -52,11 +68,15 @@ public:
 	bool isNew = true;
 	bool isDirty = true;
 	BlockType* blocks = nullptr;
+	// blocks points at an array shared by every chunk made of a single block type
+	bool sharedBlocks = false;
 	Model* model = nullptr;
 	Model* waterModel = nullptr;
 	int gridx;
 	int gridy;
 	int gridz;
+	// frame the chunk was last inside the load radius
+	int lastUsed = 0;
 	std::vector<DynamicBlock> liveBlocks;
 
 	static Material* chunkMaterial;
@@ -64,14 +84,81 @@ public:
 
 	struct Vertex {
 		Vector3 pos;
-		Vector2 uv;
+		// position in the tile, repeating past 1, and the tile's layer in the texture array
+		Vector3 uv;
 		Vector3 norm;
 		Vector4 col;
 	};
 
+	// an empty mesh with the attributes of Vertex, for everything drawn from chunk vertices
+	static GLMesh* createMesh();
+
+	// Chunks of a single block type share one read-only array. Code writing to blocks
+	// directly has to call ownBlocks() first, which copies the shared array on demand.
+	void setUniform(BlockType type);
+	BlockType* ownBlocks();
+	bool isUniform(BlockType type) const { return sharedBlocks && blocks[0] == type; }
+
+	// Level of detail the chunk is meshed at, cells are 1 << lod blocks wide. Coarser levels use
+	// downsampled copies of the blocks that are built when first needed.
+	int lod = 0;
+	static const int maxLod = 3;
+	// all (chunkSize / step)^3 cells of a coarser level of detail, step > 1. Unlike blocks
+	// they are always in linear order, y * size*size + z * size + x.
+	const BlockType* getCells(int step);
+
+	// index of a block in blocks, x, y and z have to be inside the chunk
+	static int index(int x, int y, int z) {
+#if CHUNK_LAYOUT == CHUNK_LAYOUT_MORTON
+		return spread(x) | spread(z) << 1 | spread(y) << 2;
+#elif CHUNK_LAYOUT == CHUNK_LAYOUT_TILED
+		const int bricks = chunkSize / 4;
+		return (((y >> 2) * bricks + (z >> 2)) * bricks + (x >> 2)) * 64 + (y & 3) * 16 + (z & 3) * 4 + (x & 3);
+#else
+		return y * chunkSize*chunkSize + z * chunkSize + x;
+#endif
+	}
+	BlockType getBlockUnchecked(int x, int y, int z) const { return blocks[index(x, y, z)]; }
+
+	// length blocks along x starting at (x, y, z), copied out of or into blocks
+	void readRow(int x, int y, int z, int length, BlockType* out) const {
+#if CHUNK_LAYOUT == CHUNK_LAYOUT_LINEAR
+		memcpy(out, blocks + index(x, y, z), length * sizeof(BlockType));
+#else
+		for (int i = 0; i < length; ++i) out[i] = blocks[index(x + i, y, z)];
+#endif
+	}
+	void writeRow(int x, int y, int z, int length, const BlockType* in) {
+		auto target = ownBlocks();
+#if CHUNK_LAYOUT == CHUNK_LAYOUT_LINEAR
+		memcpy(target + index(x, y, z), in, length * sizeof(BlockType));
+#else
+		for (int i = 0; i < length; ++i) target[index(x + i, y, z)] = in[i];
+#endif
+	}
+
 	BlockType getBlockAt(int x, int y, int z);
 	void setBlockAt(int x, int y, int z, BlockType type);
-	Vector4 calcLight(int x, int y, int z, int dx, int dy, int dz);
+	void markDirty(int borders);
+	static int bordersOf(int x, int y, int z);
+	Vector4 calcLight(const PaddedView& view, int x, int y, int z, int dx, int dy, int dz);
+
+	static const char* layoutName();
+
+private:
+#if CHUNK_LAYOUT == CHUNK_LAYOUT_MORTON
+	// moves bit i of v to bit 3 * i
+	static int spread(int v) {
+		v = (v | v << 8) & 0x00f00f;
+		v = (v | v << 4) & 0x0c30c3;
+		v = (v | v << 2) & 0x249249;
+		return v;
+	}
+#endif
+
+	const BlockType* getMip(int level);
+	std::vector<BlockType> mips[maxLod];
+	bool mipsValid[maxLod] = {};
 };
 
 #endif
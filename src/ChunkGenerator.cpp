@@ -0,0 +1,94 @@
+#include "ChunkGenerator.h"
+#include "WorldRandom.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+	class StageTimer {
+	public:
+		StageTimer(GeneratorStage* stage) : stage(stage), start(std::chrono::high_resolution_clock::now()) {}
+		~StageTimer() {
+			auto elapsed = std::chrono::high_resolution_clock::now() - start;
+			stage->stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+			stage->stats.runs++;
+		}
+
+	private:
+		GeneratorStage* stage;
+		std::chrono::high_resolution_clock::time_point start;
+	};
+}
+
+ChunkGenerator::ChunkGenerator(unsigned int seed) : seed(seed), columns(1024) {
+	start.x = (double)random3(seed, 0, 0, 0, 10000)/100;
+	start.y = (double)random3(seed, 1, 0, 0, 10000)/100;
+
+	heightmap = new HeightmapStage(seed);
+	addStage(heightmap);
+	addStage(new BiomeStage(seed));
+	addStage(new SurfaceStage());
+	addStage(new CaveStage(seed));
+	addStage(new OreStage());
+	addStage(new StructureStage());
+}
+
+ChunkGenerator::~ChunkGenerator() {
+	for (auto stage : stages) {
+		delete stage;
+	}
+}
+
+void ChunkGenerator::addStage(GeneratorStage* stage) {
+	stages.push_back(stage);
+}
+
+std::shared_ptr<const ColumnData> ChunkGenerator::getColumn(int gridx, int gridz) {
+	auto column = columns.find(gridx, gridz);
+	if (column) {
+		return column;
+	}
+
+	// generate outside the cache lock so other threads are not held up by the noise
+	std::shared_ptr<ColumnData> data(new ColumnData());
+	data->gridx = gridx;
+	data->gridz = gridz;
+	for (auto stage : stages) {
+		if (!stage->isColumnStage()) continue;
+		StageTimer timer(stage);
+		stage->generate(*this, *data);
+	}
+	return columns.insert(data);
+}
+
+bool ChunkGenerator::isUniform(const ColumnData& column, int gridy, BlockType& block) const {
+	int y0 = gridy*chunkSize;
+	int y1 = y0 + chunkSize - 1;
+	if (y0 <= column.topHeight) return false;
+
+	if (y0 > waterLevel) {
+		block = BlockType::AIR;
+		return true;
+	}
+	if (y1 <= waterLevel) {
+		block = BlockType::WATER;
+		return true;
+	}
+	return false;
+}
+
+void ChunkGenerator::generate(const ColumnData& column, int gridy, BlockType* blocks) {
+	for (auto stage : stages) {
+		if (stage->isColumnStage()) continue;
+		StageTimer timer(stage);
+		stage->generate(*this, column, gridy, blocks);
+	}
+}
+
+int ChunkGenerator::neighbourRadius() const {
+	int radius = 0;
+	for (auto stage : stages) {
+		radius = std::max(radius, stage->neighbourRadius);
+	}
+	return radius;
+}
@@ -1,95 +1,46 @@
 #ifndef ChunkGenerator_h
 #define ChunkGenerator_h
 
-#include "perlin.h"
 #include "Chunk.h"
+#include "ColumnCache.h"
+#include "GeneratorStage.h"
+#include "PendingWrites.h"
 
-static double ease(double v, double p) {
-	if (v > 0.5) {
-		v = (v - 0.5) * 2;
-		return (1.0 - pow(1.0 - v, p))*0.5 + 0.5;
-	}
-	else {
-		v *= 2;
-		return pow(v, p) * 0.5;
-	}
-}
+#include <memory>
+#include <vector>
 
+// Runs the generator stages. Column stages run once per column and their results are kept in
+// the column cache, chunk stages run on the blocks of every chunk in the order they were added.
 class ChunkGenerator {
 public:
+	ChunkGenerator(unsigned int seed);
+	~ChunkGenerator();
+
 	const int waterLevel = 0;
-	double* noise = nullptr;
-	int offsetx;
-	int offsetz;
-	siv::PerlinNoise perlin;
-	siv::PerlinNoise perlin2;
-	siv::PerlinNoise perlin3;
+	const int snowLevel = 80;
+	const unsigned int seed;
 	Vector2 start;
+	ColumnCache columns;
+	PendingWrites pending;
+	std::vector<GeneratorStage*> stages;
+	HeightmapStage* heightmap;
 
-	void init(int sx, int sz) {
-		offsetx = sx;
-		offsetz = sz;
-		if (!noise) {
-			noise = new double[chunkSize*chunkSize];
-		}
+	// takes ownership of the stage
+	void addStage(GeneratorStage* stage);
 
-		for (int z = sz; z < sz + chunkSize; ++z) {
-			for (int x = sx; x < sx + chunkSize; ++x) {
-				double scale = pow(perlin.noise0_1(0.0005*x + start.x, 0.0005*z + start.y), 4) * 200;
-				double ground = -50 + perlin2.noise0_1(0.0005*x + start.x, 0.0005*z + start.y) * 100;
-				double sharpness = 1.0 + pow(perlin2.noise0_1(0.01*x + start.x, 0.01*z + start.y), 4) * 50;
-				double height = ground + ease(perlin3.octaveNoise0_1(0.01*x + start.x, 0.01*z + start.y, 6), sharpness) * scale;
-				noise[(z - offsetz)*chunkSize + (x - offsetx)] = height;
-			}
-		}
-	}
+	// Returns the column data of chunk column (gridx, gridz), generating it on a cache miss.
+	// Every chunk stacked in that column shares the result, so the 2D noise runs once per column.
+	std::shared_ptr<const ColumnData> getColumn(int gridx, int gridz);
 
-	ChunkGenerator(unsigned int seed) : perlin(seed), perlin2(seed + 1), perlin3(seed + 2) {
-		srand(seed);
-		start.x = (double)(rand() % 10000)/100;
-		start.y = (double)(rand() % 10000)/100;
-	}
+	// True if chunk gridy of the column holds a single block type, which is returned in block.
+	// That is the case for chunks above everything the stages place, except where they cross the water level.
+	bool isUniform(const ColumnData& column, int gridy, BlockType& block) const;
 
-	virtual ~ChunkGenerator() {}
-	virtual BlockType getBlockAt(int x, int y, int z) {
-		int top = noise[(z - offsetz)*chunkSize + (x - offsetx)];
-		bool snow = y > 80;
+	// runs the chunk stages on the blocks of chunk gridy of the column
+	void generate(const ColumnData& column, int gridy, BlockType* blocks);
 
-		if (y > top) {
-			if (y > waterLevel) {
-				if (!snow && y == top + 1) {
-					double trees = perlin.noise0_1(0.0075*x + start.x, 0.0075*z + start.y);
-					if (trees > 0.5) {
-						trees = (trees - 0.5) * 2;
-						trees *= 0.2;
-						//if ((double)rand() / RAND_MAX < trees) return BlockType::WOOD;
-					}
-				}
-				return BlockType::AIR;
-			}
-			else return BlockType::WATER;
-		}
-		else if (y == top) {
-			if (snow) {
-				return BlockType::SNOW;
-			}
-			else {
-				if (y > waterLevel) return BlockType::GRASS;
-				else if (y > waterLevel - 3) return BlockType::SAND;
-			}
-			return BlockType::DIRT;
-		}
-		else if (y > top - 4) {
-			return BlockType::DIRT;
-		}
-		else {
-			auto chance = rand() % 100;
-			if (chance == 99) return BlockType::GOLD_ORE;
-			else if (chance > 90) return BlockType::IRON_ORE;
-			else if (chance > 75) return BlockType::COAL_ORE;
-			else return BlockType::STONE;
-		}
-	}
+	// how many chunks around its own the stages touch, neighbours a scheduler must not generate at the same time
+	int neighbourRadius() const;
 };
 
 #endif
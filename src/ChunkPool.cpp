@@ -0,0 +1,32 @@
+#include "ChunkPool.h"
+#include "Chunk.h"
+
+void ChunkPool::clear() {
+	for (auto chunk : free) {
+		delete chunk;
+	}
+	free.clear();
+}
+
+Chunk* ChunkPool::acquire(int x, int y, int z) {
+	if (free.empty()) {
+		++created;
+		return new Chunk(x, y, z);
+	}
+
+	auto chunk = free.back();
+	free.pop_back();
+	chunk->reset(x, y, z);
+	++reused;
+	return chunk;
+}
+
+void ChunkPool::release(Chunk* chunk) {
+	if (free.size() >= maxFree) {
+		delete chunk;
+		return;
+	}
+
+	chunk->releaseBlocks();
+	free.push_back(chunk);
+}
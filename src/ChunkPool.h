@@ -0,0 +1,28 @@
+#ifndef ChunkPool_h
+#define ChunkPool_h
+
+#include <vector>
+
+class Chunk;
+
+// Keeps unloaded chunks around to be loaded again somewhere else. A recycled chunk keeps its
+// models, so the GL buffers and their capacity carry over as well.
+class ChunkPool {
+public:
+	Chunk* acquire(int x, int y, int z);
+	void release(Chunk* chunk);
+	// Deletes the pooled chunks. Their models own GL objects, so this has to happen while the
+	// context is still alive, not from a destructor running after glfwTerminate.
+	void clear();
+
+	int freeChunks() const { return free.size(); }
+	// chunks beyond this are deleted on release
+	int maxFree = 512;
+	int created = 0;
+	int reused = 0;
+
+private:
+	std::vector<Chunk*> free;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "ChunkStreamer.h"
+#include "Chunk.h"
+
+#include <algorithm>
+#include <cmath>
+
+Chunk* getChunk(int gridx, int gridy, int gridz);
+
+static bool inCylinder(int dx, int dy, int dz, int radius, int height) {
+	return dx*dx + dz*dz <= radius*radius && std::abs(dy) <= height;
+}
+
+void ChunkStreamer::update(const Vector3& position, const Vector3& forward, const Vector3& velocity) {
+	eye = position;
+	view = forward;
+	speed = Vector3(velocity).length();
+	move = speed > 0.01f ? velocity * (1.0f / speed) : Vector3::zero;
+
+	int cx = chunkOf((int)std::floor(position.x));
+	int cy = chunkOf((int)std::floor(position.y));
+	int cz = chunkOf((int)std::floor(position.z));
+
+	if (!started) {
+		started = true;
+		centerX = cx;
+		centerY = cy;
+		centerZ = cz;
+		lastView = view;
+		for (int y = cy - verticalRadius; y <= cy + verticalRadius; ++y) {
+			for (int z = cz - radius; z <= cz + radius; ++z) {
+				for (int x = cx - radius; x <= cx + radius; ++x) {
+					if (inRange(x, y, z)) push(x, y, z);
+				}
+			}
+		}
+		return;
+	}
+
+	bool moved = cx != centerX || cy != centerY || cz != centerZ;
+	if (moved) {
+		// queue only the positions that just came into range
+		int oldX = centerX, oldY = centerY, oldZ = centerZ;
+		centerX = cx;
+		centerY = cy;
+		centerZ = cz;
+		for (int y = cy - verticalRadius; y <= cy + verticalRadius; ++y) {
+			for (int z = cz - radius; z <= cz + radius; ++z) {
+				for (int x = cx - radius; x <= cx + radius; ++x) {
+					if (!inRange(x, y, z) || inCylinder(x - oldX, y - oldY, z - oldZ, radius, verticalRadius)) continue;
+					push(x, y, z);
+				}
+			}
+		}
+	}
+
+	// turning by more than about 25 degrees changes what is in view
+	if (moved || view * lastView < 0.9f) {
+		lastView = view;
+		rescore();
+	}
+}
+
+bool ChunkStreamer::next(int& x, int& y, int& z) {
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end());
+		auto job = heap.back();
+		heap.pop_back();
+
+		if (!inRange(job.x, job.y, job.z) || getChunk(job.x, job.y, job.z)) {
+			++cancelled;
+			continue;
+		}
+
+		x = job.x;
+		y = job.y;
+		z = job.z;
+		return true;
+	}
+	return false;
+}
+
+bool ChunkStreamer::inRange(int x, int y, int z) const {
+	return inCylinder(x - centerX, y - centerY, z - centerZ, radius, verticalRadius);
+}
+
+bool ChunkStreamer::shouldUnload(int x, int y, int z) const {
+	return !inCylinder(x - centerX, y - centerY, z - centerZ, radius + unloadMargin, verticalRadius + unloadMargin);
+}
+
+int ChunkStreamer::cylinderChunks(int radius, int height) {
+	int column = 0;
+	for (int z = -radius; z <= radius; ++z) {
+		for (int x = -radius; x <= radius; ++x) {
+			if (inCylinder(x, 0, z, radius, height)) ++column;
+		}
+	}
+	return column * (height * 2 + 1);
+}
+
+float ChunkStreamer::score(int x, int y, int z) const {
+	Vector3 offset = Vector3(x + 0.5f, y + 0.5f, z + 0.5f) * chunkSize - eye;
+	float distance = offset.length();
+	float result = distance / chunkSize;
+	if (distance < chunkSize) return result;
+
+	Vector3 dir = offset * (1.0f / distance);
+	float facing = dir * view;
+	if (facing > viewCone) result *= inViewFactor;
+	else if (facing < 0) result *= behindFactor;
+
+	float ahead = std::max(0.0f, dir * move) * std::min(1.0f, speed / fullSpeed);
+	return result * (1.0f - velocityWeight * ahead);
+}
+
+void ChunkStreamer::push(int x, int y, int z) {
+	if (getChunk(x, y, z)) return;
+	heap.push_back(Job{ score(x, y, z), x, y, z });
+	std::push_heap(heap.begin(), heap.end());
+}
+
+void ChunkStreamer::rescore() {
+	// drop what left the range while at it, the rest keeps its place in the vector
+	heap.erase(std::remove_if(heap.begin(), heap.end(), [&](const Job& job) {
+		if (inRange(job.x, job.y, job.z)) return false;
+		++cancelled;
+		return true;
+	}), heap.end());
+
+	for (auto& job : heap) {
+		job.score = score(job.x, job.y, job.z);
+	}
+	std::make_heap(heap.begin(), heap.end());
+}
@@ -0,0 +1,71 @@
+#ifndef ChunkStreamer_h
+#define ChunkStreamer_h
+
+#include "lina.h"
+
+#include <vector>
+
+// Decides which missing chunk to generate next and which ones to unload. Chunk positions around the player wait in a
+// priority queue that is only extended when the player enters another chunk and only re-scored
+// when that happens or the view turns. Closer chunks, chunks in view and chunks ahead of the
+// movement come first. Entries that left the range or got loaded are dropped when they come up.
+class ChunkStreamer {
+public:
+	// position and velocity in blocks, forward is the normalized view direction
+	void update(const Vector3& position, const Vector3& forward, const Vector3& velocity);
+
+	// the most urgent chunk that is still missing and in range, false if there is none
+	bool next(int& x, int& y, int& z);
+
+	// Chunks are loaded within a cylinder around the player's chunk, radius chunks wide
+	// and verticalRadius chunks up and down. They are unloaded once they are margin chunks
+	// further out, so walking back and forth over a chunk border does not reload anything.
+	int radius = 5;
+	int verticalRadius = 5;
+	int unloadMargin = 2;
+
+	bool inRange(int x, int y, int z) const;
+	bool shouldUnload(int x, int y, int z) const;
+
+	// how many chunk positions are in range, and how many more are kept until they get unloaded
+	int rangeChunks() const { return cylinderChunks(radius, verticalRadius); }
+	int keptChunks() const { return cylinderChunks(radius + unloadMargin, verticalRadius + unloadMargin); }
+
+	// cosine of the half angle of the cone counted as in view, a bit wider than the camera
+	float viewCone = 0.5f;
+	// score multipliers, lower scores load first
+	float inViewFactor = 0.4f;
+	float behindFactor = 1.5f;
+	// how much moving towards a chunk pulls it forward, at full speed
+	float velocityWeight = 0.5f;
+	float fullSpeed = 20.0f;
+
+	int queued() const { return heap.size(); }
+	int cancelled = 0;
+
+private:
+	struct Job {
+		float score;
+		int x;
+		int y;
+		int z;
+
+		bool operator<(const Job& other) const { return score > other.score; }
+	};
+
+	static int cylinderChunks(int radius, int height);
+	float score(int x, int y, int z) const;
+	void push(int x, int y, int z);
+	void rescore();
+
+	std::vector<Job> heap;
+	bool started = false;
+	int centerX, centerY, centerZ;
+	Vector3 eye;
+	Vector3 view;
+	Vector3 lastView;
+	Vector3 move;
+	float speed = 0;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "ChunkView.h"
+
+#include <algorithm>
+
+Chunk* getChunk(int gridx, int gridy, int gridz);
+
+ChunkNeighbours::ChunkNeighbours(Chunk* center) {
+	for (int dy = -1; dy <= 1; ++dy) {
+		for (int dz = -1; dz <= 1; ++dz) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				auto& chunk = chunks[(dy + 1) * 9 + (dz + 1) * 3 + dx + 1];
+				chunk = dx == 0 && dy == 0 && dz == 0 ? center : getChunk(center->gridx + dx, center->gridy + dy, center->gridz + dz);
+			}
+		}
+	}
+}
+
+void PaddedView::build(const ChunkNeighbours& neighbours, int step) {
+	size = chunkSize / step;
+	above = std::max(1, 15 / step);
+	row = size + 2;
+	layer = row * row;
+	cells.assign(layer * (size + 1 + above), BlockType::AIR);
+
+	for (int dy = -1; dy <= 1; ++dy) {
+		for (int dz = -1; dz <= 1; ++dz) {
+			for (int dx = -1; dx <= 1; ++dx) {
+				auto chunk = neighbours.at(dx, dy, dz);
+				if (!chunk || !chunk->blocks) continue;
+
+				// the part of the view covered by this chunk
+				int x0 = dx < 0 ? -1 : dx * size, x1 = dx < 0 ? 0 : dx * size + (dx > 0 ? 1 : size);
+				int y0 = dy < 0 ? -1 : dy * size, y1 = dy < 0 ? 0 : dy * size + (dy > 0 ? above : size);
+				int z0 = dz < 0 ? -1 : dz * size, z1 = dz < 0 ? 0 : dz * size + (dz > 0 ? 1 : size);
+
+				if (chunk->sharedBlocks) {
+					for (int y = y0; y < y1; ++y) {
+						for (int z = z0; z < z1; ++z) {
+							std::fill_n(&cells[(y + 1) * layer + (z + 1) * row + x0 + 1], x1 - x0, chunk->blocks[0]);
+						}
+					}
+					continue;
+				}
+
+				if (step == 1) {
+					for (int y = y0; y < y1; ++y) {
+						for (int z = z0; z < z1; ++z) {
+							chunk->readRow(x0 - dx * size, y - dy * size, z - dz * size, x1 - x0, &cells[(y + 1) * layer + (z + 1) * row + x0 + 1]);
+						}
+					}
+					continue;
+				}
+
+				const BlockType* source = chunk->getCells(step);
+				for (int y = y0; y < y1; ++y) {
+					for (int z = z0; z < z1; ++z) {
+						const BlockType* src = source + ((y - dy * size) * size + (z - dz * size)) * size - dx * size;
+						BlockType* dst = &cells[(y + 1) * layer + (z + 1) * row + 1];
+						for (int x = x0; x < x1; ++x) {
+							dst[x] = src[x];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// row masks for the chunk and its one cell border
+	opaque.assign(row * row, 0);
+	filled.assign(row * row, 0);
+	for (int y = -1; y <= size; ++y) {
+		for (int z = -1; z <= size; ++z) {
+			const BlockType* src = &cells[(y + 1) * layer + (z + 1) * row];
+			std::uint64_t o = 0, f = 0;
+			for (int i = 0; i < row; ++i) {
+				o |= (std::uint64_t)(BlockRegistry::get(src[i]).flags & BLOCK_OPAQUE) << i;
+				f |= (std::uint64_t)(src[i] != BlockType::AIR) << i;
+			}
+			opaque[(y + 1) * row + z + 1] = o;
+			filled[(y + 1) * row + z + 1] = f;
+		}
+	}
+}
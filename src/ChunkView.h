@@ -0,0 +1,75 @@
+#ifndef ChunkView_h
+#define ChunkView_h
+
+#include "Chunk.h"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// index of the lowest set bit, v must not be 0
+inline int countTrailingZeros(std::uint64_t v) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return (int)index;
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+// A chunk and the 26 chunks around it, looked up once. Reads blocks anywhere from one chunk
+// below to one chunk above the centre in its local coordinates without the global chunk
+// lookup. Missing chunks read as air, like the global getBlockAt.
+class ChunkNeighbours {
+public:
+	explicit ChunkNeighbours(Chunk* center);
+
+	Chunk* at(int dx, int dy, int dz) const { return chunks[(dy + 1) * 9 + (dz + 1) * 3 + dx + 1]; }
+
+	// x, y and z have to be in [-chunkSize, 2 * chunkSize)
+	BlockType getBlockAt(int x, int y, int z) const {
+		auto chunk = at(x >> chunkShift, y >> chunkShift, z >> chunkShift);
+		return chunk ? chunk->getBlockUnchecked(x & chunkMask, y & chunkMask, z & chunkMask) : BlockType::AIR;
+	}
+
+	static bool contains(int x, int y, int z) {
+		return (unsigned)(x + chunkSize) < 3 * chunkSize && (unsigned)(y + chunkSize) < 3 * chunkSize && (unsigned)(z + chunkSize) < 3 * chunkSize;
+	}
+
+private:
+	Chunk* chunks[27];
+};
+
+// Copy of a chunk's cells at one level of detail inside a border of its neighbours' cells, so
+// the mesher can look at the neighbours of any cell without bounds checks or chunk lookups.
+// The border is one cell wide, except above, where it reaches the 15 blocks top faces look up
+// for shadows. Rows along x are also kept as bit masks, bit x + 1 for cell x, to cull whole rows
+// of faces at once.
+class PaddedView {
+public:
+	void build(const ChunkNeighbours& neighbours, int step);
+
+	// x, y and z in cells, from -1 to size, and up to size - 1 + above for y
+	BlockType at(int x, int y, int z) const { return cells[(y + 1) * layer + (z + 1) * row + x + 1]; }
+
+	// cells of row (y, z) that hide faces behind them, y and z from -1 to size
+	std::uint64_t opaqueRow(int y, int z) const { return opaque[(y + 1) * row + z + 1]; }
+	// cells of row (y, z) that are not air, they hide the faces of water
+	std::uint64_t filledRow(int y, int z) const { return filled[(y + 1) * row + z + 1]; }
+
+	int size = 0;
+	int above = 0;
+
+private:
+	int row = 0;
+	int layer = 0;
+	std::vector<BlockType> cells;
+	std::vector<std::uint64_t> opaque;
+	std::vector<std::uint64_t> filled;
+};
+
+#endif
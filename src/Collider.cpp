@@ -0,0 +1,155 @@
+#include "Collider.h"
+#include "Chunk.h"
+
+#include <algorithm>
+#include <cmath>
+
+Chunk* getChunk(int gridx, int gridy, int gridz);
+
+static float component(const Vector3& v, int axis) {
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+void VoxelCollider::gather(int minx, int miny, int minz, int maxx, int maxy, int maxz) {
+	ox = minx;
+	oy = miny;
+	oz = minz;
+	sx = maxx - minx + 1;
+	sy = maxy - miny + 1;
+	sz = maxz - minz + 1;
+	solid.assign(sx * sy * sz, 0);
+
+	// copy occupancy chunk by chunk instead of resolving the chunk per block
+	for (int cy = chunkOf(miny); cy <= chunkOf(maxy); ++cy) {
+		for (int cz = chunkOf(minz); cz <= chunkOf(maxz); ++cz) {
+			for (int cx = chunkOf(minx); cx <= chunkOf(maxx); ++cx) {
+				auto chunk = getChunk(cx, cy, cz);
+				if (!chunk || !chunk->blocks) continue;
+
+				int x0 = std::max(minx, cx * chunkSize), x1 = std::min(maxx, cx * chunkSize + chunkSize - 1);
+				int y0 = std::max(miny, cy * chunkSize), y1 = std::min(maxy, cy * chunkSize + chunkSize - 1);
+				int z0 = std::max(minz, cz * chunkSize), z1 = std::min(maxz, cz * chunkSize + chunkSize - 1);
+				for (int y = y0; y <= y1; ++y) {
+					for (int z = z0; z <= z1; ++z) {
+						for (int x = x0; x <= x1; ++x) {
+							auto block = chunk->getBlockAt(x & chunkMask, y & chunkMask, z & chunkMask);
+							solid[((y - oy) * sz + (z - oz)) * sx + (x - ox)] = isSolid(block, false);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+bool VoxelCollider::isSolidAt(int x, int y, int z) const {
+	x -= ox;
+	y -= oy;
+	z -= oz;
+	if (x < 0 || y < 0 || z < 0 || x >= sx || y >= sy || z >= sz) return false;
+	return solid[(y * sz + z) * sx + x] != 0;
+}
+
+float VoxelCollider::clip(int axis, const AABB& box, float d) const {
+	if (d == 0) return 0;
+
+	// cells covered by the box on the two other axes
+	int lo[3], hi[3];
+	for (int i = 0; i < 3; ++i) {
+		lo[i] = (int)floorf(component(box.min, i));
+		hi[i] = (int)ceilf(component(box.max, i)) - 1;
+	}
+
+	int a1 = (axis + 1) % 3;
+	int a2 = (axis + 2) % 3;
+	int cell[3];
+
+	if (d > 0) {
+		float edge = component(box.max, axis);
+		int first = (int)ceilf(edge);
+		int last = (int)floorf(edge + d + skin);
+		for (int c = first; c <= last; ++c) {
+			cell[axis] = c;
+			for (cell[a1] = lo[a1]; cell[a1] <= hi[a1]; ++cell[a1]) {
+				for (cell[a2] = lo[a2]; cell[a2] <= hi[a2]; ++cell[a2]) {
+					if (isSolidAt(cell[0], cell[1], cell[2])) {
+						return std::max(0.0f, std::min(d, c - edge - skin));
+					}
+				}
+			}
+		}
+	}
+	else {
+		float edge = component(box.min, axis);
+		int first = (int)floorf(edge) - 1;
+		int last = (int)floorf(edge + d - skin);
+		for (int c = first; c >= last; --c) {
+			cell[axis] = c;
+			for (cell[a1] = lo[a1]; cell[a1] <= hi[a1]; ++cell[a1]) {
+				for (cell[a2] = lo[a2]; cell[a2] <= hi[a2]; ++cell[a2]) {
+					if (isSolidAt(cell[0], cell[1], cell[2])) {
+						return std::min(0.0f, std::max(d, c + 1 - edge + skin));
+					}
+				}
+			}
+		}
+	}
+
+	return d;
+}
+
+CollisionResult VoxelCollider::move(const AABB& box, const Vector3& delta) {
+	CollisionResult result;
+	result.moved = Vector3::zero;
+	result.hitX = result.hitY = result.hitZ = result.grounded = false;
+
+	// gather the blocks of the whole swept volume once
+	gather(
+		(int)floorf(std::min(box.min.x, box.min.x + delta.x)) - 1,
+		(int)floorf(std::min(box.min.y, box.min.y + delta.y)) - 1,
+		(int)floorf(std::min(box.min.z, box.min.z + delta.z)) - 1,
+		(int)floorf(std::max(box.max.x, box.max.x + delta.x)) + 1,
+		(int)floorf(std::max(box.max.y, box.max.y + delta.y)) + 1,
+		(int)floorf(std::max(box.max.z, box.max.z + delta.z)) + 1
+	);
+
+	float longest = std::max(fabsf(delta.x), std::max(fabsf(delta.y), fabsf(delta.z)));
+	int steps = std::max(1, (int)ceilf(longest / maxStep));
+	Vector3 step = delta / (float)steps;
+
+	AABB cur = box;
+	for (int i = 0; i < steps; ++i) {
+		if (!result.hitY) {
+			float dy = clip(1, cur, step.y);
+			if (dy != step.y) {
+				result.hitY = true;
+				if (step.y < 0) result.grounded = true;
+			}
+			cur.min.y += dy;
+			cur.max.y += dy;
+			result.moved.y += dy;
+		}
+		if (!result.hitX) {
+			float dx = clip(0, cur, step.x);
+			if (dx != step.x) result.hitX = true;
+			cur.min.x += dx;
+			cur.max.x += dx;
+			result.moved.x += dx;
+		}
+		if (!result.hitZ) {
+			float dz = clip(2, cur, step.z);
+			if (dz != step.z) result.hitZ = true;
+			cur.min.z += dz;
+			cur.max.z += dz;
+			result.moved.z += dz;
+		}
+	}
+
+	return result;
+}
+
+void VoxelCollider::moveAll(const AABB* boxes, const Vector3* deltas, CollisionResult* results, int count) {
+	for (int i = 0; i < count; ++i) {
+		results[i] = move(boxes[i], deltas[i]);
+	}
+}
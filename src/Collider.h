@@ -0,0 +1,44 @@
+#ifndef Collider_h
+#define Collider_h
+
+#include "lina.h"
+
+#include <vector>
+
+struct AABB {
+	Vector3 min;
+	Vector3 max;
+};
+
+struct CollisionResult {
+	Vector3 moved;
+	bool hitX;
+	bool hitY;
+	bool hitZ;
+	bool grounded;
+};
+
+class VoxelCollider {
+public:
+	// largest distance a box moves on one axis before the axes are resolved again
+	float maxStep = 0.5f;
+	// gap left between a box and the block it was stopped by
+	float skin = 0.001f;
+
+	// Sweeps box by delta through the block grid, resolving y, x and z in turn.
+	CollisionResult move(const AABB& box, const Vector3& delta);
+
+	// Sweeps many boxes, e.g. one per entity.
+	void moveAll(const AABB* boxes, const Vector3* deltas, CollisionResult* results, int count);
+
+private:
+	void gather(int minx, int miny, int minz, int maxx, int maxy, int maxz);
+	bool isSolidAt(int x, int y, int z) const;
+	float clip(int axis, const AABB& box, float d) const;
+
+	std::vector<unsigned char> solid;
+	int ox, oy, oz;
+	int sx, sy, sz;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "ColumnCache.h"
+
+std::shared_ptr<const ColumnData> ColumnCache::find(int gridx, int gridz) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = index.find(key(gridx, gridz));
+	if (it == index.end()) {
+		misses++;
+		return nullptr;
+	}
+
+	// move to the front, the back is evicted first
+	columns.splice(columns.begin(), columns, it->second);
+	hits++;
+	return *it->second;
+}
+
+std::shared_ptr<const ColumnData> ColumnCache::insert(std::shared_ptr<const ColumnData> column) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// another thread may have generated the same column in the meantime
+	auto k = key(column->gridx, column->gridz);
+	auto it = index.find(k);
+	if (it != index.end()) {
+		return *it->second;
+	}
+
+	columns.push_front(column);
+	index[k] = columns.begin();
+
+	while (columns.size() > capacity) {
+		auto& last = columns.back();
+		index.erase(key(last->gridx, last->gridz));
+		columns.pop_back();
+	}
+
+	return column;
+}
+
+size_t ColumnCache::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return columns.size();
+}
@@ -0,0 +1,57 @@
+#ifndef ColumnCache_h
+#define ColumnCache_h
+
+#include "Chunk.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+enum class Biome : unsigned char {
+	OCEAN,
+	BEACH,
+	PLAINS,
+	SNOW
+};
+
+// Everything the generator knows about a chunkSize x chunkSize column of the world before
+// looking at individual blocks. Shared by all chunks stacked on top of each other.
+struct ColumnData {
+	int gridx;
+	int gridz;
+	int minHeight;
+	int maxHeight;
+	// highest block any stage places in the column, trees included
+	int topHeight;
+	int height[chunkSize*chunkSize];
+	Biome biome[chunkSize*chunkSize];
+	unsigned char trees[chunkSize*chunkSize];
+};
+
+// Bounded least-recently-used store of generated columns. Safe to use from several threads.
+class ColumnCache {
+public:
+	explicit ColumnCache(size_t capacity) : capacity(capacity) {}
+
+	std::shared_ptr<const ColumnData> find(int gridx, int gridz);
+	std::shared_ptr<const ColumnData> insert(std::shared_ptr<const ColumnData> column);
+
+	size_t size();
+	size_t capacity;
+	int hits = 0;
+	int misses = 0;
+
+private:
+	typedef std::list<std::shared_ptr<const ColumnData>> List;
+
+	static long long key(int gridx, int gridz) {
+		return (long long)((unsigned long long)(unsigned int)gridx << 32 | (unsigned int)gridz);
+	}
+
+	std::mutex mutex;
+	List columns;
+	std::unordered_map<long long, List::iterator> index;
+};
+
+#endif
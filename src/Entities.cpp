@@ -0,0 +1,291 @@
+#include "Entities.h"
+#include "Model.h"
+#include "GLMesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+static long long cellKey(int cx, int cy, int cz) {
+	return ((long long)(cx & 0x1FFFFF) << 42) | ((long long)(cy & 0x1FFFFF) << 21) | (long long)(cz & 0x1FFFFF);
+}
+
+template<typename T> static void moveLast(std::vector<T>& v, int index) {
+	v[index] = v.back();
+	v.pop_back();
+}
+
+EntitySystem::~EntitySystem() {
+	if (model) {
+		delete model;
+	}
+}
+
+void EntitySystem::init(Material* material) {
+	struct Vertex {
+		Vector3 pos;
+		Vector2 uv;
+		Vector3 norm;
+	};
+
+	// unit cube standing on the origin, faces wound counter-clockwise from outside
+	static const float faces[6][9] = {
+		{ 1, 0, 0,   0, 0, -1,   0, 1, 0 },
+		{ -1, 0, 0,  0, 0, 1,    0, 1, 0 },
+		{ 0, 1, 0,   1, 0, 0,    0, 0, -1 },
+		{ 0, -1, 0,  1, 0, 0,    0, 0, 1 },
+		{ 0, 0, 1,   1, 0, 0,    0, 1, 0 },
+		{ 0, 0, -1,  -1, 0, 0,   0, 1, 0 },
+	};
+	static const float corners[4][2] = { { -1, -1 },{ 1, -1 },{ 1, 1 },{ -1, 1 } };
+
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (int f = 0; f < 6; ++f) {
+		Vector3 n(faces[f][0], faces[f][1], faces[f][2]);
+		Vector3 u(faces[f][3], faces[f][4], faces[f][5]);
+		Vector3 v(faces[f][6], faces[f][7], faces[f][8]);
+		Vector3 center = Vector3(0, 0.5f, 0) + n * 0.5f;
+		for (int c = 0; c < 4; ++c) {
+			Vector3 pos = center + u * (corners[c][0] * 0.5f) + v * (corners[c][1] * 0.5f);
+			Vector2 uv((corners[c][0] + 1) / 2, (corners[c][1] + 1) / 2);
+			vertices.push_back({ pos, uv, n });
+		}
+		unsigned int base = f * 4;
+		indices.push_back(base + 0);
+		indices.push_back(base + 1);
+		indices.push_back(base + 2);
+		indices.push_back(base + 2);
+		indices.push_back(base + 3);
+		indices.push_back(base + 0);
+	}
+
+	model = new Model();
+	model->position = Vector3::zero;
+	model->rotation = Quaternion::identity;
+	model->fade = 0;
+	model->material = material;
+	model->mesh = new GLMesh({
+		{ 3, GL_FLOAT, sizeof(float) },
+		{ 2, GL_FLOAT, sizeof(float) },
+		{ 3, GL_FLOAT, sizeof(float) },
+	});
+	model->mesh->setInstanceElements({
+		{ 3, GL_FLOAT, sizeof(float) },
+		{ 3, GL_FLOAT, sizeof(float) },
+		{ 1, GL_FLOAT, sizeof(float) },
+	});
+	model->mesh->setVertices(vertices.data(), sizeof(Vertex), vertices.size(), GL_STATIC_DRAW);
+	model->mesh->setIndices(indices.data(), sizeof(unsigned int), indices.size(), GL_STATIC_DRAW);
+}
+
+EntityHandle EntitySystem::spawn(EntityType entityType, BlockType blockType, const Vector3& position, const Vector3& velocity) {
+	int slot;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = slots.size();
+		slots.push_back(Slot{ -1, 0 });
+	}
+
+	int index = count();
+	slots[slot].index = index;
+	slotOf.push_back(slot);
+
+	float r, h;
+	switch (entityType) {
+	case EntityType::ITEM:
+		r = 0.125f;
+		h = 0.25f;
+		break;
+	case EntityType::FALLING_BLOCK:
+		r = 0.49f;
+		h = 0.98f;
+		break;
+	case EntityType::MOB:
+	default:
+		r = 0.3f;
+		h = 1.7f;
+	}
+
+	posX.push_back(position.x);
+	posY.push_back(position.y);
+	posZ.push_back(position.z);
+	velX.push_back(velocity.x);
+	velY.push_back(velocity.y);
+	velZ.push_back(velocity.z);
+	radius.push_back(r);
+	height.push_back(h);
+	age.push_back(0);
+	type.push_back(entityType);
+	block.push_back(blockType);
+	grounded.push_back(0);
+
+	return EntityHandle{ slot, slots[slot].generation };
+}
+
+int EntitySystem::indexOf(EntityHandle handle) const {
+	if (handle.slot < 0 || handle.slot >= slots.size()) return -1;
+	if (slots[handle.slot].generation != handle.generation) return -1;
+	return slots[handle.slot].index;
+}
+
+EntityHandle EntitySystem::handleAt(int index) const {
+	int slot = slotOf[index];
+	return EntityHandle{ slot, slots[slot].generation };
+}
+
+void EntitySystem::destroy(EntityHandle handle) {
+	int index = indexOf(handle);
+	if (index >= 0) removeAt(index);
+}
+
+void EntitySystem::destroyIndices(std::vector<int>& indices) {
+	// remove from the back so the remaining indices stay valid
+	std::sort(indices.begin(), indices.end(), [](int a, int b) { return a > b; });
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	for (auto index : indices) {
+		removeAt(index);
+	}
+}
+
+void EntitySystem::removeAt(int index) {
+	int slot = slotOf[index];
+	slots[slot].generation++;
+	slots[slot].index = -1;
+	freeSlots.push_back(slot);
+
+	int last = count() - 1;
+	if (index != last) {
+		slots[slotOf[last]].index = index;
+	}
+
+	moveLast(slotOf, index);
+	moveLast(posX, index);
+	moveLast(posY, index);
+	moveLast(posZ, index);
+	moveLast(velX, index);
+	moveLast(velY, index);
+	moveLast(velZ, index);
+	moveLast(radius, index);
+	moveLast(height, index);
+	moveLast(age, index);
+	moveLast(type, index);
+	moveLast(block, index);
+	moveLast(grounded, index);
+}
+
+void EntitySystem::update(float dt, VoxelCollider& collider) {
+	int n = count();
+
+	for (int i = 0; i < n; ++i) {
+		velY[i] -= gravity * dt;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		age[i] += dt;
+	}
+
+	// ground friction
+	float friction = std::max(0.0f, 1.0f - 8.0f * dt);
+	for (int i = 0; i < n; ++i) {
+		float f = grounded[i] ? friction : 1.0f;
+		velX[i] *= f;
+		velZ[i] *= f;
+	}
+
+	boxes.resize(n);
+	deltas.resize(n);
+	results.resize(n);
+	for (int i = 0; i < n; ++i) {
+		boxes[i].min = Vector3(posX[i] - radius[i], posY[i], posZ[i] - radius[i]);
+		boxes[i].max = Vector3(posX[i] + radius[i], posY[i] + height[i], posZ[i] + radius[i]);
+		deltas[i] = Vector3(velX[i] * dt, velY[i] * dt, velZ[i] * dt);
+	}
+
+	collider.moveAll(boxes.data(), deltas.data(), results.data(), n);
+
+	for (int i = 0; i < n; ++i) {
+		auto& r = results[i];
+		posX[i] += r.moved.x;
+		posY[i] += r.moved.y;
+		posZ[i] += r.moved.z;
+		if (r.hitX) velX[i] = 0;
+		if (r.hitY) velY[i] = 0;
+		if (r.hitZ) velZ[i] = 0;
+		grounded[i] = r.grounded;
+	}
+
+	dead.clear();
+	landings.clear();
+	for (int i = 0; i < n; ++i) {
+		if (type[i] == EntityType::ITEM && age[i] > itemLifetime) {
+			dead.push_back(i);
+		}
+		else if (type[i] == EntityType::FALLING_BLOCK && grounded[i]) {
+			landings.push_back(Landing{ (int)floorf(posX[i]), (int)floorf(posY[i] + 0.5f), (int)floorf(posZ[i]), block[i] });
+			dead.push_back(i);
+		}
+	}
+	destroyIndices(dead);
+
+	rebuildSpatialHash();
+}
+
+void EntitySystem::rebuildSpatialHash() {
+	int n = count();
+	cellKeys.resize(n);
+	cellOrder.resize(n);
+	for (int i = 0; i < n; ++i) {
+		cellKeys[i] = cellKey(chunkOf((int)floorf(posX[i])), chunkOf((int)floorf(posY[i])), chunkOf((int)floorf(posZ[i])));
+		cellOrder[i] = i;
+	}
+
+	std::sort(cellOrder.begin(), cellOrder.end(), [&](int a, int b) {
+		return cellKeys[a] < cellKeys[b];
+	});
+
+	cells.clear();
+	for (int i = 0; i < n;) {
+		auto key = cellKeys[cellOrder[i]];
+		int j = i + 1;
+		while (j < n && cellKeys[cellOrder[j]] == key) ++j;
+		cells[key] = Cell{ i, j - i };
+		i = j;
+	}
+}
+
+void EntitySystem::query(const Vector3& min, const Vector3& max, std::vector<int>& result) const {
+	// entities are hashed by their position, so widen the search by the largest entity extent
+	int minx = chunkOf((int)floorf(min.x - 1)), maxx = chunkOf((int)floorf(max.x + 1));
+	int miny = chunkOf((int)floorf(min.y - 2)), maxy = chunkOf((int)floorf(max.y));
+	int minz = chunkOf((int)floorf(min.z - 1)), maxz = chunkOf((int)floorf(max.z + 1));
+
+	for (int cy = miny; cy <= maxy; ++cy) {
+		for (int cz = minz; cz <= maxz; ++cz) {
+			for (int cx = minx; cx <= maxx; ++cx) {
+				auto it = cells.find(cellKey(cx, cy, cz));
+				if (it == cells.end()) continue;
+				for (int k = 0; k < it->second.count; ++k) {
+					int i = cellOrder[it->second.start + k];
+					if (posX[i] + radius[i] < min.x || posX[i] - radius[i] > max.x) continue;
+					if (posY[i] + height[i] < min.y || posY[i] > max.y) continue;
+					if (posZ[i] + radius[i] < min.z || posZ[i] - radius[i] > max.z) continue;
+					result.push_back(i);
+				}
+			}
+		}
+	}
+}
+
+void EntitySystem::buildInstances() {
+	int n = count();
+	instances.resize(n);
+	for (int i = 0; i < n; ++i) {
+		instances[i].offset = Vector3(posX[i], posY[i], posZ[i]);
+		instances[i].size = Vector3(radius[i] * 2, height[i], radius[i] * 2);
+		instances[i].layer = BlockRegistry::get(block[i]).tiles[FACE_FRONT];
+	}
+	model->mesh->setInstances(instances.data(), sizeof(Instance), n, GL_STREAM_DRAW);
+}
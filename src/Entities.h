@@ -0,0 +1,106 @@
+#ifndef Entities_h
+#define Entities_h
+
+#include "lina.h"
+#include "Chunk.h"
+#include "Collider.h"
+
+#include <vector>
+#include <unordered_map>
+
+class Model;
+class Material;
+
+enum class EntityType : unsigned char {
+	ITEM,
+	FALLING_BLOCK,
+	MOB
+};
+
+struct EntityHandle {
+	int slot;
+	unsigned int generation;
+};
+
+// Entities are stored as parallel component arrays indexed by a dense entity index.
+// Destroying an entity moves the last one into its place, so dense indices are only
+// valid until the next destroy; hold on to an EntityHandle to refer to an entity longer.
+class EntitySystem {
+public:
+	struct Instance {
+		Vector3 offset;
+		Vector3 size;
+		// texture array layer of the block's tile
+		float layer;
+	};
+
+	struct Landing {
+		int x;
+		int y;
+		int z;
+		BlockType block;
+	};
+
+	~EntitySystem();
+
+	void init(Material* material);
+
+	EntityHandle spawn(EntityType type, BlockType block, const Vector3& position, const Vector3& velocity);
+	void destroy(EntityHandle handle);
+	void destroyIndices(std::vector<int>& indices);
+	int indexOf(EntityHandle handle) const;
+	EntityHandle handleAt(int index) const;
+	int count() const { return (int)type.size(); }
+
+	void update(float dt, VoxelCollider& collider);
+	void query(const Vector3& min, const Vector3& max, std::vector<int>& result) const;
+	void buildInstances();
+
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> velX, velY, velZ;
+	std::vector<float> radius;
+	std::vector<float> height;
+	std::vector<float> age;
+	std::vector<EntityType> type;
+	std::vector<BlockType> block;
+	std::vector<unsigned char> grounded;
+
+	// falling blocks that came to rest during the last update and were removed
+	std::vector<Landing> landings;
+
+	float gravity = 15.81f;
+	float itemLifetime = 60.0f;
+
+	Model* model = nullptr;
+
+private:
+	struct Slot {
+		int index;
+		unsigned int generation;
+	};
+
+	struct Cell {
+		int start;
+		int count;
+	};
+
+	void removeAt(int index);
+	void rebuildSpatialHash();
+
+	std::vector<Slot> slots;
+	std::vector<int> freeSlots;
+	std::vector<int> slotOf;
+
+	// chunk-aligned spatial hash, rebuilt once per update
+	std::vector<long long> cellKeys;
+	std::vector<int> cellOrder;
+	std::unordered_map<long long, Cell> cells;
+
+	std::vector<AABB> boxes;
+	std::vector<Vector3> deltas;
+	std::vector<CollisionResult> results;
+	std::vector<int> dead;
+	std::vector<Instance> instances;
+};
+
+#endif
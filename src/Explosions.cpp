@@ -0,0 +1,130 @@
+#include "Explosions.h"
+#include "Chunk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+Chunk* getChunk(int gridx, int gridy, int gridz);
+void activateBlock(int x, int y, int z);
+
+void Explosions::ignite(int x, int y, int z, float fuse) {
+	for (auto& f : fuses) {
+		if (f.x == x && f.y == y && f.z == z) return;
+	}
+	fuses.push_back(Fuse{ x, y, z, fuse });
+}
+
+int Explosions::pendingChunks() const {
+	int num = 0;
+	for (auto& blast : blasts) {
+		num += blast.chunks.size();
+	}
+	return num;
+}
+
+void Explosions::update(float dt) {
+	for (int i = 0; i < fuses.size();) {
+		fuses[i].time -= dt;
+		if (fuses[i].time <= 0) {
+			detonate(fuses[i].x, fuses[i].y, fuses[i].z);
+			fuses[i] = fuses.back();
+			fuses.pop_back();
+		}
+		else {
+			++i;
+		}
+	}
+
+	int budget = maxChunksPerFrame;
+	while (budget > 0 && !blasts.empty()) {
+		auto& blast = blasts.front();
+		if (!blast.chunks.empty()) {
+			auto pos = blast.chunks.back();
+			blast.chunks.pop_back();
+			auto chunk = getChunk(pos.x, pos.y, pos.z);
+			if (chunk && chunk->blocks) {
+				clearChunk(chunk, blast);
+				--budget;
+			}
+		}
+		if (blast.chunks.empty()) {
+			finish(blast);
+			blasts.erase(blasts.begin());
+		}
+	}
+}
+
+void Explosions::detonate(int x, int y, int z) {
+	Blast blast{ x, y, z, radius };
+	int r = (int)ceilf(radius);
+	for (int cy = chunkOf(y - r); cy <= chunkOf(y + r); ++cy) {
+		for (int cz = chunkOf(z - r); cz <= chunkOf(z + r); ++cz) {
+			for (int cx = chunkOf(x - r); cx <= chunkOf(x + r); ++cx) {
+				blast.chunks.push_back(ChunkPos{ cx, cy, cz });
+			}
+		}
+	}
+	blasts.push_back(blast);
+}
+
+void Explosions::clearChunk(Chunk* chunk, const Blast& blast) {
+	if (chunk->isUniform(BlockType::AIR)) return;
+
+	int ox = chunk->gridx * chunkSize;
+	int oy = chunk->gridy * chunkSize;
+	int oz = chunk->gridz * chunkSize;
+	float r2 = blast.radius * blast.radius;
+
+	bool changed = false;
+	int borders = 0;
+
+	for (int y = 0; y < chunkSize; ++y) {
+		float dy = (float)(oy + y - blast.y);
+		if (dy * dy > r2) continue;
+		for (int z = 0; z < chunkSize; ++z) {
+			float dz = (float)(oz + z - blast.z);
+			float rem = r2 - dy * dy - dz * dz;
+			if (rem < 0) continue;
+
+			// the sphere cuts a contiguous span out of every row
+			float half = sqrtf(rem);
+			int x0 = std::max(0, (int)ceilf(blast.x - half) - ox);
+			int x1 = std::min(chunkSize - 1, (int)floorf(blast.x + half) - ox);
+			if (x0 > x1) continue;
+
+			BlockType* blocks = chunk->ownBlocks();
+			for (int x = x0; x <= x1; ++x) {
+				auto& block = blocks[Chunk::index(x, y, z)];
+				if (block == BlockType::AIR) continue;
+				auto flags = BlockRegistry::get(block).flags;
+				if (flags & BLOCK_BLAST_PROOF) continue;
+				if ((flags & BLOCK_EXPLOSIVE) && (ox + x != blast.x || oy + y != blast.y || oz + z != blast.z)) {
+					ignite(ox + x, oy + y, oz + z, 0.5f + (rand() % 100) * 0.01f);
+				}
+				block = BlockType::AIR;
+				changed = true;
+				borders |= Chunk::bordersOf(x, y, z);
+			}
+		}
+	}
+
+	// one remesh for the chunk, plus the neighbours whose border faces are now exposed
+	if (changed) {
+		chunk->markDirty(borders);
+	}
+}
+
+void Explosions::finish(const Blast& blast) {
+	// blocks resting on the crater may have lost their support
+	int r = (int)ceilf(blast.radius);
+	float r2 = blast.radius * blast.radius;
+	for (int dz = -r; dz <= r; ++dz) {
+		for (int dx = -r; dx <= r; ++dx) {
+			float rem = r2 - dx * dx - dz * dz;
+			if (rem < 0) continue;
+			int top = (int)floorf(blast.y + sqrtf(rem));
+			activateBlock(blast.x + dx, top + 1, blast.z + dz);
+		}
+	}
+}
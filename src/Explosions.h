@@ -0,0 +1,49 @@
+#ifndef Explosions_h
+#define Explosions_h
+
+#include <vector>
+
+class Chunk;
+
+// Burning TNT fuses and the blasts they cause. A blast clears a sphere of blocks one chunk
+// at a time, each chunk in a single pass, spread over frames so big chains don't stall.
+class Explosions {
+public:
+	void ignite(int x, int y, int z, float fuse);
+	void update(float dt);
+	int pendingChunks() const;
+
+	float radius = 4.5f;
+	int maxChunksPerFrame = 4;
+
+private:
+	struct Fuse {
+		int x;
+		int y;
+		int z;
+		float time;
+	};
+
+	struct ChunkPos {
+		int x;
+		int y;
+		int z;
+	};
+
+	struct Blast {
+		int x;
+		int y;
+		int z;
+		float radius;
+		std::vector<ChunkPos> chunks;
+	};
+
+	void detonate(int x, int y, int z);
+	void clearChunk(Chunk* chunk, const Blast& blast);
+	void finish(const Blast& blast);
+
+	std::vector<Fuse> fuses;
+	std::vector<Blast> blasts;
+};
+
+#endif
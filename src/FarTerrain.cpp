@@ -0,0 +1,186 @@
+#include "FarTerrain.h"
+#include "ChunkGenerator.h"
+#include "Chunk.h"
+#include "Model.h"
+#include "GLMesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+void FarTerrain::init(ChunkGenerator* gen, Material* material) {
+	this->gen = gen;
+
+	for (int i = 0; i < numLevels; ++i) {
+		levels[i].spacing = baseSpacing << i;
+	}
+
+	model = new Model();
+	model->position = Vector3::zero;
+	model->rotation = Quaternion::identity;
+	model->material = material;
+	model->mesh = Chunk::createMesh();
+}
+
+void FarTerrain::update(const Vector3& position) {
+	bool changed = false;
+	for (auto& level : levels) {
+		// centered on a multiple of twice the spacing, so every ring lines up with the next coarser one
+		int snap = level.spacing * 2;
+		int centerX = (int)std::floor(position.x / snap) * snap;
+		int centerZ = (int)std::floor(position.z / snap) * snap;
+		if (level.valid && level.centerX == centerX && level.centerZ == centerZ) continue;
+
+		updateLevel(level, centerX, centerZ);
+		changed = true;
+	}
+
+	if (changed) {
+		buildMesh();
+	}
+}
+
+float FarTerrain::visibleRadius() const {
+	// the outermost ring is centered up to two of its cells away from the camera
+	return (float)((halfCells - 2) * (baseSpacing << (numLevels - 1)));
+}
+
+void FarTerrain::updateLevel(Level& level, int centerX, int centerZ) {
+	int n = halfCells * 2 + 1;
+	std::vector<float> heights(n*n);
+	std::vector<int> missing;
+	missingX.clear();
+	missingZ.clear();
+
+	// keep the heights that are still inside the ring, only the new rows and columns need noise
+	int shiftX = level.valid ? (centerX - level.centerX) / level.spacing : 0;
+	int shiftZ = level.valid ? (centerZ - level.centerZ) / level.spacing : 0;
+	for (int z = 0; z < n; ++z) {
+		for (int x = 0; x < n; ++x) {
+			int ox = x + shiftX;
+			int oz = z + shiftZ;
+			if (level.valid && ox >= 0 && oz >= 0 && ox < n && oz < n) {
+				heights[z*n + x] = level.heights[oz*n + ox];
+			}
+			else {
+				missing.push_back(z*n + x);
+				missingX.push_back(centerX + (x - halfCells) * level.spacing);
+				missingZ.push_back(centerZ + (z - halfCells) * level.spacing);
+			}
+		}
+	}
+
+	missingHeights.resize(missing.size());
+	gen->heightmap->fillHeights(*gen, missingX.data(), missingZ.data(), missingHeights.data(), missing.size());
+	for (int i = 0; i < missing.size(); ++i) {
+		// the top face of the highest block, like the chunks show it
+		heights[missing[i]] = (float)((int)missingHeights[i] + 1);
+	}
+
+	level.heights.swap(heights);
+	level.centerX = centerX;
+	level.centerZ = centerZ;
+	level.valid = true;
+}
+
+void FarTerrain::buildMesh() {
+	static std::vector<Chunk::Vertex> vertices;
+	static std::vector<unsigned int> indices;
+	vertices.clear();
+	indices.clear();
+
+	int n = halfCells * 2 + 1;
+	int originX = levels[0].centerX;
+	int originZ = levels[0].centerZ;
+	model->position = Vector3(originX, 0, originZ);
+
+	// centre of the tile on the top face of a block
+	auto tile = [](BlockType block) {
+		return Vector3(0.5f, 0.5f, BlockRegistry::get(block).tiles[FACE_TOP]);
+	};
+
+	for (int l = 0; l < numLevels; ++l) {
+		auto& level = levels[l];
+		int s = level.spacing;
+		int base = vertices.size();
+
+		for (int z = 0; z < n; ++z) {
+			for (int x = 0; x < n; ++x) {
+				float h = level.heights[z*n + x];
+				int top = (int)h - 1;
+
+				Vector3 uv;
+				float drop = sink + landSink * s;
+				if (top > gen->snowLevel) uv = tile(BlockType::SNOW);
+				else if (top > gen->waterLevel) uv = tile(BlockType::GRASS);
+				else if (top > gen->waterLevel - 3) uv = tile(BlockType::SAND);
+				else {
+					uv = tile(BlockType::WATER);
+					h = (float)gen->waterLevel + 1;
+					drop = sink;
+				}
+
+				float dx = level.heights[z*n + std::min(x + 1, n - 1)] - level.heights[z*n + std::max(x - 1, 0)];
+				float dz = level.heights[std::min(z + 1, n - 1)*n + x] - level.heights[std::max(z - 1, 0)*n + x];
+				Vector3 normal = Vector3(-dx / (2 * s), 1, -dz / (2 * s)).normalized();
+
+				Vector3 pos(level.centerX - originX + (x - halfCells) * s, h - drop, level.centerZ - originZ + (z - halfCells) * s);
+				vertices.push_back({ pos, uv, normal, Vector4::white });
+			}
+		}
+
+		// the hole is the loaded chunks for the innermost ring and the ring inside for the others
+		int holeX0, holeZ0, holeX1, holeZ1;
+		if (l == 0) {
+			holeX0 = level.centerX - innerRadius;
+			holeZ0 = level.centerZ - innerRadius;
+			holeX1 = level.centerX + innerRadius;
+			holeZ1 = level.centerZ + innerRadius;
+		}
+		else {
+			auto& inner = levels[l - 1];
+			int extent = halfCells * inner.spacing;
+			holeX0 = inner.centerX - extent;
+			holeZ0 = inner.centerZ - extent;
+			holeX1 = inner.centerX + extent;
+			holeZ1 = inner.centerZ + extent;
+		}
+
+		for (int z = 0; z < n - 1; ++z) {
+			for (int x = 0; x < n - 1; ++x) {
+				int wx = level.centerX + (x - halfCells) * s;
+				int wz = level.centerZ + (z - halfCells) * s;
+				if (wx >= holeX0 && wx + s <= holeX1 && wz >= holeZ0 && wz + s <= holeZ1) continue;
+
+				unsigned int a = base + z*n + x;
+				unsigned int b = a + n;
+				unsigned int c = a + n + 1;
+				unsigned int d = a + 1;
+				indices.insert(indices.end(), { a, b, c, c, d, a });
+			}
+		}
+
+		// a skirt hanging down the outer edge hides the cracks towards the coarser ring
+		std::vector<unsigned int> edge;
+		for (int i = 0; i < n - 1; ++i) edge.push_back(base + i);
+		for (int i = 0; i < n - 1; ++i) edge.push_back(base + i*n + n - 1);
+		for (int i = n - 1; i > 0; --i) edge.push_back(base + (n - 1)*n + i);
+		for (int i = n - 1; i > 0; --i) edge.push_back(base + i*n);
+
+		int skirt = vertices.size();
+		for (auto i : edge) {
+			auto vertex = vertices[i];
+			vertex.pos.y -= s * 2;
+			vertices.push_back(vertex);
+		}
+		for (int i = 0; i < edge.size(); ++i) {
+			int j = (i + 1) % edge.size();
+			unsigned int a = edge[i], b = edge[j];
+			unsigned int c = skirt + j, d = skirt + i;
+			// both sides, the skirt is seen from inside and outside the ring
+			indices.insert(indices.end(), { a, b, c, c, d, a, a, d, c, c, b, a });
+		}
+	}
+
+	model->mesh->setVertices(vertices.data(), sizeof(Chunk::Vertex), vertices.size(), GL_STATIC_DRAW);
+	model->mesh->setIndices(indices.data(), sizeof(unsigned int), indices.size(), GL_STATIC_DRAW);
+}
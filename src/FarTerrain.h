@@ -0,0 +1,54 @@
+#ifndef FarTerrain_h
+#define FarTerrain_h
+
+#include "lina.h"
+
+#include <vector>
+
+class ChunkGenerator;
+class Material;
+class Model;
+
+// Terrain beyond the loaded chunks, drawn from the generator's heightmap alone. It is a set of
+// nested square rings, each twice as coarse and twice as wide as the one inside it, that follow
+// the camera. Heights are kept per ring, so moving only computes the rows that came into view.
+class FarTerrain {
+public:
+	void init(ChunkGenerator* gen, Material* material);
+	void update(const Vector3& position);
+	// how far the rings reach at least in every direction, wherever the camera is in its cell
+	float visibleRadius() const;
+
+	Model* model = nullptr;
+
+	// half width of the hole left for the loaded chunks, has to stay inside the load range
+	int innerRadius = 64;
+	// spacing of the innermost ring
+	int baseSpacing = 8;
+	// cells from the center to the edge of every ring
+	int halfCells = 32;
+	static const int numLevels = 4;
+	// the rings sit a little lower so loaded chunks always cover them
+	float sink = 3;
+	// Land sinks further, by this part of the ring's spacing. Between samples that far apart the
+	// flat triangles can pass high above a valley, water is flat and does not need it.
+	float landSink = 0.5f;
+
+private:
+	struct Level {
+		int spacing;
+		int centerX = 0;
+		int centerZ = 0;
+		bool valid = false;
+		std::vector<float> heights;
+	};
+
+	void updateLevel(Level& level, int centerX, int centerZ);
+	void buildMesh();
+
+	ChunkGenerator* gen = nullptr;
+	Level levels[numLevels];
+	std::vector<double> missingX, missingZ, missingHeights;
+};
+
+#endif
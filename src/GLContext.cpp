@@ -1,15 +1,13 @@
 #include "GLContext.h"
 
-#include "GLVertexShader.h"
-#include "GLFragmentShader.h"
 #include "GLProgram.h"
 #include "GLTexture.h"
 #include "GLMesh.h"
+#include "TextureCache.h"
 #include "lina.h"
 
-#include "stb_image.h"
+#include <algorithm>
 
-std::string readFile(const std::string& name);
 void error(const std::string& msg);
 
 void GLContext::clearAll(const Vector4& col, double depth) {
@@ -45,47 +43,51 @@ void GLContext::use(GLProgram* program) {
 }
 
 GLTexture* GLContext::loadTexture(const char* name) {
-	unsigned int handle;
-	glGenTextures(1, &handle);
-	glBindTexture(GL_TEXTURE_2D, handle);
-
-	stbi_set_flip_vertically_on_load(true);
+	auto image = TextureCache::load(name, 1, 1);
+	if (!image) return nullptr;
+	auto texture = createTexture(*image, GL_TEXTURE_2D);
+	delete image;
+	return texture;
+}
 
-	int width, height, nrChannels;
-	unsigned char *data = stbi_load(name, &width, &height, &nrChannels, 0);
-	if (!data) {
-		glDeleteTextures(1, &handle);
-		return nullptr;
-	}
+GLTexture* GLContext::loadTextureArray(const char* name, int columns, int rows) {
+	auto image = TextureCache::load(name, columns, rows);
+	if (!image) return nullptr;
+	auto texture = createTexture(*image, GL_TEXTURE_2D_ARRAY);
+	delete image;
+	return texture;
+}
 
-	unsigned int format;
-	switch (nrChannels) {
-	case 4:
-		format = GL_RGBA;
-		break;
-	case 3:
-	default:
-		format = GL_RGB;
+GLTexture* GLContext::createTexture(const TextureImage& image, GLenum target) {
+	unsigned int handle;
+	glGenTextures(1, &handle);
+	glBindTexture(target, handle);
+
+	// the mips come with the image, nothing is generated here
+	for (int l = 0; l < image.levels; ++l) {
+		if (target == GL_TEXTURE_2D_ARRAY) {
+			glTexImage3D(target, l, GL_RGBA8, image.levelWidth(l), image.levelHeight(l), image.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.level(l));
+		}
+		else {
+			glTexImage2D(target, l, GL_RGBA8, image.levelWidth(l), image.levelHeight(l), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.level(l));
+		}
 	}
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, image.levels - 1);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	stbi_image_free(data);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
 	auto texture = new GLTexture();
 	texture->handle = handle;
+	texture->target = target;
 	return texture;
 }
 
 void GLContext::bind(GLTexture* texture, int slot) {
 	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, texture->handle);
+	glBindTexture(texture->target, texture->handle);
 }
 
 void GLContext::enable(unsigned int option) {
@@ -97,63 +99,29 @@ void GLContext::disable(unsigned int option) {
 }
 
 GLProgram* GLContext::createProgram(const char* vsFile, const char* fsFile) {
-	auto vs = createVertexShader(vsFile);
-	if (!vs) return nullptr;
-	auto fs = createFragmentShader(fsFile);
-	if (!fs) return nullptr;
-	
-	auto handle = glCreateProgram();
-	glAttachShader(handle, vs->handle);
-	glAttachShader(handle, fs->handle);
-	glLinkProgram(handle);
-
-	int success;
-	glGetProgramiv(handle, GL_LINK_STATUS, &success);
-	if (!success) {
-		char msg[512];
-		glGetProgramInfoLog(handle, sizeof(msg), nullptr, msg);
-		error(msg);
-		glDeleteProgram(handle);
-		return nullptr;
-	}
-	
-	return new GLProgram(handle);
+	return programs.get(*this, vsFile, fsFile);
 }
 
-GLVertexShader* GLContext::createVertexShader(const char* vsName) {
-	auto handle = glCreateShader(GL_VERTEX_SHADER);
-	auto src = readFile(vsName);
-	auto srcPtr = src.c_str();
-	glShaderSource(handle, 1, &srcPtr, nullptr);
-	glCompileShader(handle);
-	int success;
-	glGetShaderiv(handle, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		char msg[512];
-		glGetShaderInfoLog(handle, sizeof(msg), nullptr, msg);
-		error(msg);
-		glDeleteShader(handle);
-		return nullptr;
-	}
-
-	return new GLVertexShader(handle);
+int GLContext::reloadPrograms() {
+	return programs.reload(*this);
 }
 
-GLFragmentShader* GLContext::createFragmentShader(const char* fsName) {
-	auto handle = glCreateShader(GL_FRAGMENT_SHADER);
-	auto src = readFile(fsName);
-	auto srcPtr = src.c_str();
+GLuint GLContext::compileShader(GLenum type, const std::string& source, const std::string& name) {
+	auto handle = glCreateShader(type);
+	auto srcPtr = source.c_str();
 	glShaderSource(handle, 1, &srcPtr, nullptr);
 	glCompileShader(handle);
 	int success;
 	glGetShaderiv(handle, GL_COMPILE_STATUS, &success);
 	if (!success) {
-		char msg[512];
-		glGetShaderInfoLog(handle, sizeof(msg), nullptr, msg);
-		error(msg);
+		int length = 0;
+		glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &length);
+		std::string log(std::max(length, 1), '\0');
+		glGetShaderInfoLog(handle, log.size(), nullptr, &log[0]);
+		error(name + ":\n" + log.c_str());
 		glDeleteShader(handle);
-		return nullptr;
+		return 0;
 	}
 
-	return new GLFragmentShader(handle);
-}
\ No newline at end of file
+	return handle;
+}
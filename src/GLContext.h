@@ -3,11 +3,14 @@
 
 #include <glad/glad.h>
 
+#include "ProgramCache.h"
+
+#include <string>
+
 class GLTexture;
+class TextureImage;
 class GLMesh;
 class GLProgram;
-class GLVertexShader;
-class GLFragmentShader;
 struct Vector4;
 
 class GLContext {
@@ -16,6 +19,7 @@ public:
 	int height;
 	
 	GLProgram* currentProgram = nullptr;
+	ProgramCache programs;
 
 	void clearAll(const Vector4& col, double depth);
 	void clearColor(const Vector4& col);
@@ -24,11 +28,18 @@ public:
 	void drawIndexed(GLenum mode, GLsizei count, GLenum type, const void* indices);
 	void use(GLProgram* program);
 	GLTexture* loadTexture(const char* name);
+	// splits an atlas of columns x rows equally sized tiles into the layers of a texture array
+	GLTexture* loadTextureArray(const char* name, int columns, int rows);
+	// uploads an image and its mips as a GL_TEXTURE_2D or, for tiled images, a GL_TEXTURE_2D_ARRAY
+	GLTexture* createTexture(const TextureImage& image, GLenum target);
 	void bind(GLTexture* texture, int slot);
 	void enable(unsigned int option);
 	void disable(unsigned int option);
+	// the same pair of files always gives the same program, see ProgramCache
 	GLProgram* createProgram(const char* vs, const char* fs);
-	GLVertexShader* createVertexShader(const char* vs);
-	GLFragmentShader* createFragmentShader(const char* fs);
+	// rebuilds the programs whose shader files changed, returns how many
+	int reloadPrograms();
+	// the shader handle, 0 after reporting the full compile log
+	GLuint compileShader(GLenum type, const std::string& source, const std::string& name);
 };
 #endif
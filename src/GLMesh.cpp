@@ -4,4 +4,7 @@
 	glDeleteVertexArrays(1, &vao);
 	glDeleteBuffers(1, &vbo);
 	glDeleteBuffers(1, &ebo);
+	if (instanceVbo) {
+		glDeleteBuffers(1, &instanceVbo);
+	}
 }
\ No newline at end of file
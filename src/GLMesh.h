@@ -15,6 +15,7 @@ public:
 	};
 
 	bool useIndices = true;
+	bool useInstances = false;
 	enum class PrimitiveType {
 		TRIANGLES,
 		LINES
@@ -39,25 +40,74 @@ public:
 			glEnableVertexAttribArray(i);
 			offset += elements[i].size * elements[i].count;
 		}
+		numAttributes = elements.size();
+	}
+
+	// Adds per-instance attributes after the per-vertex ones; draw() then renders numInstances copies.
+	void setInstanceElements(const std::vector<Element>& elements) {
+		glGenBuffers(1, &instanceVbo);
+
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+
+		size_t stride = 0;
+		for (auto& el : elements) {
+			stride += el.count * el.size;
+		}
+
+		size_t offset = 0;
+		for (int i = 0; i < elements.size(); ++i) {
+			glVertexAttribPointer(numAttributes + i, elements[i].count, elements[i].type, GL_FALSE, stride, (void*)offset);
+			glEnableVertexAttribArray(numAttributes + i);
+			glVertexAttribDivisor(numAttributes + i, 1);
+			offset += elements[i].size * elements[i].count;
+		}
+		useInstances = true;
 	}
 
 	~GLMesh();
 
+private:
+	static void upload(unsigned int target, const void* data, size_t bytes, size_t& capacity, unsigned int usage) {
+		if (bytes > capacity) {
+			capacity = bytes + bytes / 2;
+			glBufferData(target, capacity, nullptr, usage);
+		}
+		if (bytes > 0) {
+			glBufferSubData(target, 0, bytes, data);
+		}
+	}
+
+public:
+
+	// Buffers only grow. Smaller uploads reuse the storage, so remeshing a chunk
+	// or recycling its mesh for another chunk does not reallocate on the driver side.
 	void setIndices(const void* data, size_t size, size_t count, unsigned int usage) {
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, size*count, data, usage);
+		upload(GL_ELEMENT_ARRAY_BUFFER, data, size*count, indexCapacity, usage);
 		numIndices = count;
 	}
 
 	void setVertices(const void* data, size_t size, size_t count, unsigned int usage) {
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, size*count, data, usage);
+		upload(GL_ARRAY_BUFFER, data, size*count, vertexCapacity, usage);
 		numVertices = count;
 	}
 
+	void setInstances(const void* data, size_t size, size_t count, unsigned int usage) {
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+		glBufferData(GL_ARRAY_BUFFER, size*count, data, usage);
+		numInstances = count;
+	}
+
 	void draw() {
 		glBindVertexArray(vao);
-		if (useIndices) {
+		if (useInstances) {
+			if (numInstances == 0) return;
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+			glDrawElementsInstanced(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0, numInstances);
+		}
+		else if (useIndices) {
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 			if (primitiveType == PrimitiveType::TRIANGLES) {
 				glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
@@ -72,9 +122,14 @@ public:
 
 	int numVertices;
 	int numIndices;
+	size_t vertexCapacity = 0;
+	size_t indexCapacity = 0;
+	int numInstances = 0;
+	int numAttributes = 0;
 	GLuint vbo;
 	GLuint vao;
 	GLuint ebo;
+	GLuint instanceVbo = 0;
 };
 
 #endif
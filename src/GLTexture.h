@@ -1,9 +1,13 @@
 #ifndef GLTexture_H
 #define GLTexture_H
 
+#include <glad/glad.h>
+
 class GLTexture {
 public:
 	unsigned int handle;
+	// GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+	GLenum target = GL_TEXTURE_2D;
 }; 
 
 #endif
@@ -0,0 +1,266 @@
+#include "GeneratorStage.h"
+#include "ChunkGenerator.h"
+#include "WorldRandom.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+namespace {
+	// keep ores and trees from sharing random values
+	const std::uint32_t oreSalt = 0x6f726573;
+	const std::uint32_t treeSalt = 0x74726565;
+
+	double ease(double v, double p) {
+		if (v > 0.5) {
+			v = (v - 0.5) * 2;
+			return (1.0 - pow(1.0 - v, p))*0.5 + 0.5;
+		}
+		else {
+			v *= 2;
+			return pow(v, p) * 0.5;
+		}
+	}
+}
+
+HeightmapStage::HeightmapStage(std::uint32_t seed) : GeneratorStage("heightmap", 0), batch(seed), batch2(seed + 1), batch3(seed + 2) {
+}
+
+void HeightmapStage::generate(ChunkGenerator& gen, ColumnData& column) {
+	const int num = chunkSize*chunkSize;
+	double heights[num];
+	fillHeightmap(gen, column.gridx*chunkSize, column.gridz*chunkSize, heights);
+
+	column.minHeight = INT_MAX;
+	column.maxHeight = INT_MIN;
+	for (int i = 0; i < num; ++i) {
+		int top = heights[i];
+		column.height[i] = top;
+		column.minHeight = std::min(column.minHeight, top);
+		column.maxHeight = std::max(column.maxHeight, top);
+	}
+	column.topHeight = column.maxHeight;
+}
+
+void HeightmapStage::fillHeightmap(ChunkGenerator& gen, int sx, int sz, double* heights) const {
+	const int num = chunkSize*chunkSize;
+	std::vector<double> x(num), z(num);
+	for (int i = 0; i < num; ++i) {
+		x[i] = sx + i % chunkSize;
+		z[i] = sz + i / chunkSize;
+	}
+	fillHeights(gen, x.data(), z.data(), heights, num);
+}
+
+// The noise runs through PerlinBatch, which gives exactly the same values as the scalar siv::PerlinNoise.
+void HeightmapStage::fillHeights(ChunkGenerator& gen, const double* x, const double* z, double* heights, int count) const {
+	std::vector<double> coarseX(count), coarseZ(count), fineX(count), fineZ(count);
+	std::vector<double> scaleNoise(count), groundNoise(count), sharpNoise(count), detailNoise(count);
+
+	for (int i = 0; i < count; ++i) {
+		coarseX[i] = 0.0005*x[i] + gen.start.x;
+		coarseZ[i] = 0.0005*z[i] + gen.start.y;
+		fineX[i] = 0.01*x[i] + gen.start.x;
+		fineZ[i] = 0.01*z[i] + gen.start.y;
+	}
+
+	batch.noise0_1(coarseX.data(), coarseZ.data(), scaleNoise.data(), count);
+	batch2.noise0_1(coarseX.data(), coarseZ.data(), groundNoise.data(), count);
+	batch2.noise0_1(fineX.data(), fineZ.data(), sharpNoise.data(), count);
+	batch3.octaveNoise0_1(fineX.data(), fineZ.data(), 6, detailNoise.data(), count);
+
+	for (int i = 0; i < count; ++i) {
+		double scale = pow(scaleNoise[i], 4) * 200;
+		double ground = -50 + groundNoise[i] * 100;
+		double sharpness = 1.0 + pow(sharpNoise[i], 4) * 50;
+		heights[i] = ground + ease(detailNoise[i], sharpness) * scale;
+	}
+}
+
+BiomeStage::BiomeStage(std::uint32_t seed) : GeneratorStage("biome", 0), batch(seed) {
+}
+
+void BiomeStage::generate(ChunkGenerator& gen, ColumnData& column) {
+	const int num = chunkSize*chunkSize;
+	int sx = column.gridx*chunkSize;
+	int sz = column.gridz*chunkSize;
+
+	std::vector<double> treeX(num), treeZ(num), trees(num);
+	for (int z = 0; z < chunkSize; ++z) {
+		for (int x = 0; x < chunkSize; ++x) {
+			int i = z * chunkSize + x;
+			treeX[i] = 0.0075*(sx + x) + gen.start.x;
+			treeZ[i] = 0.0075*(sz + z) + gen.start.y;
+		}
+	}
+	batch.noise0_1(treeX.data(), treeZ.data(), trees.data(), num);
+
+	for (int i = 0; i < num; ++i) {
+		int top = column.height[i];
+		if (top > gen.snowLevel) column.biome[i] = Biome::SNOW;
+		else if (top > gen.waterLevel) column.biome[i] = Biome::PLAINS;
+		else if (top > gen.waterLevel - 3) column.biome[i] = Biome::BEACH;
+		else column.biome[i] = Biome::OCEAN;
+
+		// tree density, zero where the tree noise is below one half and where nothing grows
+		double t = trees[i] > 0.5 && column.biome[i] == Biome::PLAINS ? (trees[i] - 0.5) * 2 : 0.0;
+		column.trees[i] = (unsigned char)(t * 255);
+		if (column.trees[i] > 0) {
+			column.topHeight = std::max(column.topHeight, top + StructureStage::treeHeight);
+		}
+	}
+}
+
+void SurfaceStage::generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) {
+	const int layer = chunkSize*chunkSize;
+
+	// layers above or below the terrain band are written without looking at the heightmap
+	for (int y = 0; y < chunkSize; ++y) {
+		int wy = gridy*chunkSize + y;
+		BlockType* row = blocks + y*layer;
+
+		if (wy > column.maxHeight) {
+			std::fill(row, row + layer, wy > gen.waterLevel ? BlockType::AIR : BlockType::WATER);
+		}
+		else if (wy <= column.minHeight - 4) {
+			std::fill(row, row + layer, BlockType::STONE);
+		}
+		else {
+			for (int i = 0; i < layer; ++i) {
+				int top = column.height[i];
+				if (wy > top) row[i] = wy > gen.waterLevel ? BlockType::AIR : BlockType::WATER;
+				else if (wy == top) {
+					switch (column.biome[i]) {
+					case Biome::SNOW: row[i] = BlockType::SNOW; break;
+					case Biome::PLAINS: row[i] = BlockType::GRASS; break;
+					case Biome::BEACH: row[i] = BlockType::SAND; break;
+					default: row[i] = BlockType::DIRT; break;
+					}
+				}
+				else if (wy > top - 4) row[i] = BlockType::DIRT;
+				else row[i] = BlockType::STONE;
+			}
+		}
+	}
+}
+
+CaveStage::CaveStage(std::uint32_t seed) : GeneratorStage("caves", 0), perlin(seed + 3) {
+}
+
+void CaveStage::generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) {
+	// caves stay below the dirt, so chunks without stone are left alone
+	int y0 = gridy*chunkSize;
+	int layers = std::min(chunkSize, column.maxHeight - 4 - y0);
+	if (layers <= 0) return;
+
+	// 3D noise is sampled every 4 blocks and interpolated in between
+	const int step = 4;
+	const int n = chunkSize / step + 1;
+	double lattice[n][n][n];
+	int sx = column.gridx*chunkSize;
+	int sz = column.gridz*chunkSize;
+	for (int y = 0; y < n; ++y) {
+		for (int z = 0; z < n; ++z) {
+			for (int x = 0; x < n; ++x) {
+				lattice[y][z][x] = perlin.noise0_1((sx + x*step)*0.03, (y0 + y*step)*0.05, (sz + z*step)*0.03);
+			}
+		}
+	}
+
+	const double inv = 1.0 / step;
+	for (int y = 0; y < layers; ++y) {
+		int ly = y / step;
+		double fy = (y % step) * inv;
+		for (int z = 0; z < chunkSize; ++z) {
+			int lz = z / step;
+			double fz = (z % step) * inv;
+			for (int x = 0; x < chunkSize; ++x) {
+				auto& block = blocks[y * chunkSize*chunkSize + z * chunkSize + x];
+				if (block != BlockType::STONE || y0 + y >= column.height[z * chunkSize + x] - 4) continue;
+
+				int lx = x / step;
+				double fx = (x % step) * inv;
+				double a = lattice[ly][lz][lx] + (lattice[ly][lz][lx + 1] - lattice[ly][lz][lx]) * fx;
+				double b = lattice[ly][lz + 1][lx] + (lattice[ly][lz + 1][lx + 1] - lattice[ly][lz + 1][lx]) * fx;
+				double c = lattice[ly + 1][lz][lx] + (lattice[ly + 1][lz][lx + 1] - lattice[ly + 1][lz][lx]) * fx;
+				double d = lattice[ly + 1][lz + 1][lx] + (lattice[ly + 1][lz + 1][lx + 1] - lattice[ly + 1][lz + 1][lx]) * fx;
+				double ab = a + (b - a) * fz;
+				double cd = c + (d - c) * fz;
+				if (ab + (cd - ab) * fy > threshold) {
+					block = BlockType::AIR;
+				}
+			}
+		}
+	}
+}
+
+void OreStage::generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) {
+	int y0 = gridy*chunkSize;
+	int layers = std::min(chunkSize, column.maxHeight - 3 - y0);
+	const std::uint32_t seed = gen.seed ^ oreSalt;
+	int sx = column.gridx*chunkSize;
+	int sz = column.gridz*chunkSize;
+
+	// Every block only depends on the world seed and its own coordinates. The loop body is plain
+	// integer arithmetic and selects without branches, so the compiler vectorizes it.
+	for (int y = 0; y < layers; ++y) {
+		for (int z = 0; z < chunkSize; ++z) {
+			BlockType* row = blocks + y * chunkSize*chunkSize + z * chunkSize;
+			for (int x = 0; x < chunkSize; ++x) {
+				std::uint32_t chance = random3(seed, sx + x, y0 + y, sz + z, 100);
+				unsigned char ore = (unsigned char)BlockType::STONE;
+				ore = chance > 75 ? (unsigned char)BlockType::COAL_ORE : ore;
+				ore = chance > 90 ? (unsigned char)BlockType::IRON_ORE : ore;
+				ore = chance == 99 ? (unsigned char)BlockType::GOLD_ORE : ore;
+				unsigned char block = (unsigned char)row[x];
+				row[x] = (BlockType)(block == (unsigned char)BlockType::STONE ? ore : block);
+			}
+		}
+	}
+}
+
+void StructureStage::generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) {
+	int y0 = gridy*chunkSize;
+	if (y0 > column.topHeight || y0 + chunkSize <= column.minHeight) return;
+
+	const std::uint32_t seed = gen.seed ^ treeSalt;
+	int sx = column.gridx*chunkSize;
+	int sz = column.gridz*chunkSize;
+
+	// blocks outside this chunk are queued for the neighbour they land in
+	auto place = [&](int x, int y, int z, BlockType block) {
+		if (x < 0 || y < 0 || z < 0 || x >= chunkSize || y >= chunkSize || z >= chunkSize) {
+			gen.pending.add(column.gridx, gridy, column.gridz, sx + x, y0 + y, sz + z, block);
+			return;
+		}
+		auto& target = blocks[y * chunkSize*chunkSize + z * chunkSize + x];
+		if (block != BlockType::LEAVES || target == BlockType::AIR) target = block;
+	};
+
+	for (int z = 0; z < chunkSize; ++z) {
+		for (int x = 0; x < chunkSize; ++x) {
+			int i = z * chunkSize + x;
+			if (column.trees[i] == 0) continue;
+
+			// a tree belongs to the chunk its trunk starts in
+			int y = column.height[i] + 1 - y0;
+			if (y < 0 || y >= chunkSize) continue;
+			if (random01(seed, sx + x, y0 + y, sz + z) >= column.trees[i] / 255.0f * 0.02f) continue;
+
+			int trunk = 4 + random3(seed, sx + x, y0 + y + 1, sz + z, 3);
+			for (int ly = trunk - 2; ly <= trunk + 1; ++ly) {
+				int r = ly < trunk ? 2 : 1;
+				for (int dz = -r; dz <= r; ++dz) {
+					for (int dx = -r; dx <= r; ++dx) {
+						if (r == 2 && dx*dx == 4 && dz*dz == 4) continue;
+						place(x + dx, y + ly, z + dz, BlockType::LEAVES);
+					}
+				}
+			}
+			for (int ly = 0; ly < trunk; ++ly) {
+				place(x, y + ly, z, BlockType::WOOD);
+			}
+		}
+	}
+}
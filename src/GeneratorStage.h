@@ -0,0 +1,112 @@
+#ifndef GeneratorStage_h
+#define GeneratorStage_h
+
+#include "Chunk.h"
+#include "ColumnCache.h"
+#include "PerlinBatch.h"
+#include "perlin.h"
+
+#include <atomic>
+#include <cstdint>
+
+class ChunkGenerator;
+
+struct StageStats {
+	std::atomic<long long> runs{ 0 };
+	std::atomic<long long> nanoseconds{ 0 };
+
+	double averageMicroseconds() const {
+		long long n = runs;
+		return n > 0 ? nanoseconds / 1000.0 / n : 0.0;
+	}
+};
+
+// One step of world generation. Column stages run once per column and fill in ColumnData,
+// chunk stages run once per chunk, in order, on the blocks written by the stages before them.
+class GeneratorStage {
+public:
+	GeneratorStage(const char* name, int neighbourRadius) : name(name), neighbourRadius(neighbourRadius) {}
+	virtual ~GeneratorStage() {}
+
+	virtual bool isColumnStage() const { return false; }
+	virtual void generate(ChunkGenerator& gen, ColumnData& column) {}
+	virtual void generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) {}
+
+	const char* name;
+	// how many chunks away from its own this stage reads or writes, 0 if it stays inside the chunk
+	int neighbourRadius;
+	StageStats stats;
+};
+
+// terrain height of every column, from 2D noise
+class HeightmapStage : public GeneratorStage {
+public:
+	HeightmapStage(std::uint32_t seed);
+
+	bool isColumnStage() const override { return true; }
+	void generate(ChunkGenerator& gen, ColumnData& column) override;
+
+	// fills the heights of the chunkSize x chunkSize columns starting at (sx, sz), row by row in z
+	void fillHeightmap(ChunkGenerator& gen, int sx, int sz, double* heights) const;
+	// heights at arbitrary block positions, used for terrain beyond the loaded chunks
+	void fillHeights(ChunkGenerator& gen, const double* x, const double* z, double* heights, int count) const;
+
+private:
+	PerlinBatch batch;
+	PerlinBatch batch2;
+	PerlinBatch batch3;
+};
+
+// surface biome and tree density of every column
+class BiomeStage : public GeneratorStage {
+public:
+	BiomeStage(std::uint32_t seed);
+
+	bool isColumnStage() const override { return true; }
+	void generate(ChunkGenerator& gen, ColumnData& column) override;
+
+private:
+	PerlinBatch batch;
+};
+
+// ground, surface blocks and water, one y layer at a time
+class SurfaceStage : public GeneratorStage {
+public:
+	SurfaceStage() : GeneratorStage("surface", 0) {}
+
+	void generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) override;
+};
+
+// carves caves out of the stone below the dirt layer
+class CaveStage : public GeneratorStage {
+public:
+	CaveStage(std::uint32_t seed);
+
+	void generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) override;
+
+	double threshold = 0.72;
+
+private:
+	siv::PerlinNoise perlin;
+};
+
+// turns part of the stone into ores
+class OreStage : public GeneratorStage {
+public:
+	OreStage() : GeneratorStage("ores", 0) {}
+
+	void generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) override;
+};
+
+// trees, the parts reaching into neighbouring chunks go to the generator's pending writes
+class StructureStage : public GeneratorStage {
+public:
+	StructureStage() : GeneratorStage("structures", 1) {}
+
+	void generate(ChunkGenerator& gen, const ColumnData& column, int gridy, BlockType* blocks) override;
+
+	// blocks a tree reaches above the ground it stands on
+	static const int treeHeight = 8;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+bool MappedFile::open(const std::string& name) {
+	close();
+
+	file = CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		close();
+		return false;
+	}
+
+	bytes = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!bytes) {
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close() {
+	if (bytes) UnmapViewOfFile(bytes);
+	if (mapping) CloseHandle(mapping);
+	if (file) CloseHandle(file);
+	bytes = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	length = 0;
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::open(const std::string& name) {
+	close();
+
+	int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (address == MAP_FAILED) return false;
+
+	bytes = (const unsigned char*)address;
+	length = info.st_size;
+	return true;
+}
+
+void MappedFile::close() {
+	if (bytes) munmap((void*)bytes, length);
+	bytes = nullptr;
+	length = 0;
+}
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
@@ -0,0 +1,46 @@
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file mapped into memory, with mmap on POSIX systems and a file
+// mapping on Windows. The pages are only read from disk when touched.
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// false if the file does not exist or is empty
+	bool open(const std::string& name);
+	void close();
+
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// FNV-1a of a block of memory, for telling whether a cache still matches its sources. Pass the
+// previous result as seed to hash several blocks as one.
+inline std::uint64_t hashBytes(const void* data, size_t size, std::uint64_t seed = 0xcbf29ce484222325ull) {
+	auto bytes = (const unsigned char*)data;
+	std::uint64_t h = seed;
+	for (size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= 0x100000001b3ull;
+	}
+	return h;
+}
+
+#endif
@@ -13,6 +13,9 @@ public:
 	Vector3 position;
 	Quaternion rotation;
 	float fade = 1.0f;
+	// where the model sits in the RenderList, -1 while it is not drawn
+	int renderGroup = -1;
+	int renderSlot = -1;
 
 	~Model();
 };
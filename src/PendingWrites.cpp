@@ -0,0 +1,73 @@
+#include "PendingWrites.h"
+
+#include <algorithm>
+
+void PendingWrites::add(int ox, int oy, int oz, int x, int y, int z, BlockType block) {
+	int cx = chunkOf(x), cy = chunkOf(y), cz = chunkOf(z);
+	auto local = blockInChunk(x, y, z);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	writes[key(cx, cy, cz)].push_back(Write{ ox, oy, oz, (unsigned char)local.x, (unsigned char)local.y, (unsigned char)local.z, block });
+}
+
+void PendingWrites::apply(Chunk* chunk) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = writes.find(key(chunk->gridx, chunk->gridy, chunk->gridz));
+	if (it == writes.end()) return;
+	apply(chunk, it->second, true, 0, 0, 0);
+}
+
+void PendingWrites::apply(Chunk* chunk, int ox, int oy, int oz) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = writes.find(key(chunk->gridx, chunk->gridy, chunk->gridz));
+	if (it == writes.end()) return;
+	apply(chunk, it->second, false, ox, oy, oz);
+}
+
+void PendingWrites::apply(Chunk* chunk, const std::vector<Write>& list, bool all, int ox, int oy, int oz) {
+	int borders = 0;
+	bool changed = false;
+	for (auto& write : list) {
+		if (!all && (write.ox != ox || write.oy != oy || write.oz != oz)) continue;
+		int index = Chunk::index(write.x, write.y, write.z);
+		if (write.block == BlockType::LEAVES && chunk->blocks[index] != BlockType::AIR) continue;
+		if (chunk->blocks[index] == write.block) continue;
+
+		chunk->ownBlocks()[index] = write.block;
+		borders |= Chunk::bordersOf(write.x, write.y, write.z);
+		changed = true;
+	}
+
+	if (changed) {
+		chunk->markDirty(borders);
+	}
+}
+
+void PendingWrites::dropOrigin(int ox, int oy, int oz, int radius) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (int y = oy - radius; y <= oy + radius; ++y) {
+		for (int z = oz - radius; z <= oz + radius; ++z) {
+			for (int x = ox - radius; x <= ox + radius; ++x) {
+				auto it = writes.find(key(x, y, z));
+				if (it == writes.end()) continue;
+
+				auto& list = it->second;
+				list.erase(std::remove_if(list.begin(), list.end(), [&](const Write& write) {
+					return write.ox == ox && write.oy == oy && write.oz == oz;
+				}), list.end());
+				if (list.empty()) {
+					writes.erase(it);
+				}
+			}
+		}
+	}
+}
+
+size_t PendingWrites::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t count = 0;
+	for (auto& entry : writes) {
+		count += entry.second.size();
+	}
+	return count;
+}
@@ -0,0 +1,51 @@
+#ifndef PendingWrites_h
+#define PendingWrites_h
+
+#include "Chunk.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Blocks that generation placed outside the chunk being generated, like the leaves of a tree
+// growing next to a chunk border. Writes are stored by the chunk they land in and remember the
+// chunk that caused them. They stay around as long as that chunk is loaded, so a neighbour that
+// is generated (or regenerated) later still gets them.
+class PendingWrites {
+public:
+	// stores a write from chunk (ox, oy, oz) to world block (x, y, z)
+	void add(int ox, int oy, int oz, int x, int y, int z, BlockType block);
+
+	// Writes everything queued for the chunk into it. Leaves only replace air.
+	void apply(Chunk* chunk);
+	// writes only what chunk (ox, oy, oz) queued for the chunk, for chunks that were loaded before it
+	void apply(Chunk* chunk, int ox, int oy, int oz);
+
+	// forgets the writes of an unloaded chunk, generating it again queues them again
+	void dropOrigin(int ox, int oy, int oz, int radius);
+
+	size_t size();
+
+private:
+	struct Write {
+		int ox;
+		int oy;
+		int oz;
+		// position inside the chunk
+		unsigned char x;
+		unsigned char y;
+		unsigned char z;
+		BlockType block;
+	};
+
+	static long long key(int x, int y, int z) {
+		return ((long long)(x & 0x1fffff) << 42) | ((long long)(y & 0x1fffff) << 21) | (long long)(z & 0x1fffff);
+	}
+
+	void apply(Chunk* chunk, const std::vector<Write>& writes, bool all, int ox, int oy, int oz);
+
+	std::mutex mutex;
+	std::unordered_map<long long, std::vector<Write>> writes;
+};
+
+#endif
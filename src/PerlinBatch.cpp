@@ -0,0 +1,180 @@
+#include "PerlinBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PERLIN_SSE2
+#endif
+
+namespace {
+	// Grad(hash, x, y, 0) of siv::PerlinNoise written as gradX * x + gradY * y
+	struct GradTable {
+		double x[16];
+		double y[16];
+
+		GradTable() {
+			for (int h = 0; h < 16; ++h) {
+				double u = h < 8 ? 1 : 0;
+				double v = h < 4 ? 1 : 0;
+				double uy = h < 8 ? 0 : 1;
+				double vx = h == 12 || h == 14 ? 1 : 0;
+				double su = (h & 1) == 0 ? 1 : -1;
+				double sv = (h & 2) == 0 ? 1 : -1;
+				x[h] = u * su + vx * sv;
+				y[h] = uy * su + v * sv;
+			}
+		}
+	};
+
+	const GradTable grad;
+
+	struct Scalar {
+		typedef double V;
+		static const int width = 1;
+		static V load(const double* p) { return *p; }
+		static void store(double* p, V v) { *p = v; }
+		static V set(const double* p) { return *p; }
+		static V splat(double d) { return d; }
+		static V add(V a, V b) { return a + b; }
+		static V sub(V a, V b) { return a - b; }
+		static V mul(V a, V b) { return a * b; }
+	};
+
+#if defined(__AVX__)
+	struct Wide {
+		typedef __m256d V;
+		static const int width = 4;
+		static V load(const double* p) { return _mm256_loadu_pd(p); }
+		static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+		static V set(const double* p) { return _mm256_set_pd(p[3], p[2], p[1], p[0]); }
+		static V splat(double d) { return _mm256_set1_pd(d); }
+		static V add(V a, V b) { return _mm256_add_pd(a, b); }
+		static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+		static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+	};
+#elif defined(PERLIN_SSE2)
+	struct Wide {
+		typedef __m128d V;
+		static const int width = 2;
+		static V load(const double* p) { return _mm_loadu_pd(p); }
+		static void store(double* p, V v) { _mm_storeu_pd(p, v); }
+		static V set(const double* p) { return _mm_set_pd(p[1], p[0]); }
+		static V splat(double d) { return _mm_set1_pd(d); }
+		static V add(V a, V b) { return _mm_add_pd(a, b); }
+		static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+		static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+	};
+#else
+	typedef Scalar Wide;
+#endif
+
+	template<typename S> typename S::V fade(typename S::V t) {
+		// t * t * t * (t * (t * 6 - 15) + 10)
+		auto inner = S::add(S::mul(t, S::sub(S::mul(t, S::splat(6)), S::splat(15))), S::splat(10));
+		return S::mul(S::mul(S::mul(t, t), t), inner);
+	}
+
+	template<typename S> typename S::V lerp(typename S::V t, typename S::V a, typename S::V b) {
+		return S::add(a, S::mul(t, S::sub(b, a)));
+	}
+
+	template<typename S> typename S::V gradient(const double* gx, const double* gy, typename S::V x, typename S::V y) {
+		return S::add(S::mul(S::set(gx), x), S::mul(S::set(gy), y));
+	}
+
+	template<typename S> void noiseKernel(const std::int32_t* p, const double* x, const double* y, double* out) {
+		const int n = S::width;
+		double fx[n], fy[n];
+		double gx00[n], gy00[n], gx10[n], gy10[n], gx01[n], gy01[n], gx11[n], gy11[n];
+
+		for (int i = 0; i < n; ++i) {
+			fx[i] = std::floor(x[i]);
+			fy[i] = std::floor(y[i]);
+			const std::int32_t X = static_cast<std::int32_t>(fx[i]) & 255;
+			const std::int32_t Y = static_cast<std::int32_t>(fy[i]) & 255;
+			const std::int32_t A = p[X] + Y, AA = p[A], AB = p[A + 1];
+			const std::int32_t B = p[X + 1] + Y, BA = p[B], BB = p[B + 1];
+			const std::int32_t h00 = p[AA] & 15, h10 = p[BA] & 15, h01 = p[AB] & 15, h11 = p[BB] & 15;
+			gx00[i] = grad.x[h00]; gy00[i] = grad.y[h00];
+			gx10[i] = grad.x[h10]; gy10[i] = grad.y[h10];
+			gx01[i] = grad.x[h01]; gy01[i] = grad.y[h01];
+			gx11[i] = grad.x[h11]; gy11[i] = grad.y[h11];
+		}
+
+		auto one = S::splat(1);
+		auto xf = S::sub(S::load(x), S::load(fx));
+		auto yf = S::sub(S::load(y), S::load(fy));
+		auto xf1 = S::sub(xf, one);
+		auto yf1 = S::sub(yf, one);
+		auto u = fade<S>(xf);
+		auto v = fade<S>(yf);
+
+		auto a = lerp<S>(u, gradient<S>(gx00, gy00, xf, yf), gradient<S>(gx10, gy10, xf1, yf));
+		auto b = lerp<S>(u, gradient<S>(gx01, gy01, xf, yf1), gradient<S>(gx11, gy11, xf1, yf1));
+		S::store(out, lerp<S>(v, a, b));
+	}
+}
+
+PerlinBatch::PerlinBatch(std::uint32_t seed) {
+	// same permutation as siv::PerlinNoise::reseed
+	for (size_t i = 0; i < 256; ++i) {
+		p[i] = i;
+	}
+
+	std::shuffle(std::begin(p), std::begin(p) + 256, std::default_random_engine(seed));
+
+	for (size_t i = 0; i < 256; ++i) {
+		p[256 + i] = p[i];
+	}
+}
+
+void PerlinBatch::noise(const double* x, const double* y, double* out, int count) const {
+	int i = 0;
+	for (; i + Wide::width <= count; i += Wide::width) {
+		noiseKernel<Wide>(p, x + i, y + i, out + i);
+	}
+	for (; i < count; ++i) {
+		noiseKernel<Scalar>(p, x + i, y + i, out + i);
+	}
+}
+
+void PerlinBatch::noise0_1(const double* x, const double* y, double* out, int count) const {
+	noise(x, y, out, count);
+	for (int i = 0; i < count; ++i) {
+		out[i] = out[i] * 0.5 + 0.5;
+	}
+}
+
+void PerlinBatch::octaveNoise0_1(const double* x, const double* y, int octaves, double* out, int count) const {
+	const int batch = 64;
+	double sx[batch], sy[batch], n[batch];
+
+	for (int start = 0; start < count; start += batch) {
+		int num = std::min(batch, count - start);
+		for (int i = 0; i < num; ++i) {
+			sx[i] = x[start + i];
+			sy[i] = y[start + i];
+			out[start + i] = 0.0;
+		}
+
+		double amp = 1.0;
+		for (int o = 0; o < octaves; ++o) {
+			noise(sx, sy, n, num);
+			for (int i = 0; i < num; ++i) {
+				out[start + i] += n[i] * amp;
+				sx[i] *= 2.0;
+				sy[i] *= 2.0;
+			}
+			amp *= 0.5;
+		}
+
+		for (int i = 0; i < num; ++i) {
+			out[start + i] = out[start + i] * 0.5 + 0.5;
+		}
+	}
+}
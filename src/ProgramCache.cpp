@@ -0,0 +1,212 @@
+#include "ProgramCache.h"
+#include "GLContext.h"
+#include "GLProgram.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+std::string readFile(const std::string& name);
+void error(const std::string& msg);
+
+namespace {
+	struct Header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceHash;
+		std::uint32_t format;
+		std::uint32_t length;
+	};
+
+	const char magic[4] = { 'P', 'R', 'G', 'C' };
+	const std::uint32_t version = 1;
+
+	// binaries only work with the driver that made them, so it is part of the hash
+	std::uint64_t sourceHash(const std::string& vsSource, const std::string& fsSource) {
+		auto renderer = (const char*)glGetString(GL_RENDERER);
+		auto driver = (const char*)glGetString(GL_VERSION);
+		auto h = hashBytes(vsSource.data(), vsSource.size());
+		h = hashBytes(fsSource.data(), fsSource.size(), h);
+		if (renderer) h = hashBytes(renderer, strlen(renderer), h);
+		if (driver) h = hashBytes(driver, strlen(driver), h);
+		return h;
+	}
+
+	std::string stem(const std::string& name) {
+		auto slash = name.find_last_of("/\\");
+		auto start = slash == std::string::npos ? 0 : slash + 1;
+		auto dot = name.find_last_of('.');
+		return name.substr(start, dot == std::string::npos || dot < start ? std::string::npos : dot - start);
+	}
+}
+
+std::string ProgramCache::cacheName(const std::string& vsFile, const std::string& fsFile) {
+	auto slash = vsFile.find_last_of("/\\");
+	auto dir = slash == std::string::npos ? std::string() : vsFile.substr(0, slash + 1);
+	return dir + stem(vsFile) + "+" + stem(fsFile) + ".cache";
+}
+
+GLProgram* ProgramCache::get(GLContext& gl, const std::string& vsFile, const std::string& fsFile) {
+	for (auto& entry : entries) {
+		if (entry.vsFile == vsFile && entry.fsFile == fsFile) return entry.program;
+	}
+
+	Entry entry;
+	entry.vsFile = vsFile;
+	entry.fsFile = fsFile;
+
+	auto vsSource = readFile(vsFile);
+	auto fsSource = readFile(fsFile);
+	entry.hash = sourceHash(vsSource, fsSource);
+
+	auto handle = build(gl, entry, vsSource, fsSource);
+	if (!handle) return nullptr;
+
+	entry.program = new GLProgram(handle);
+	entries.push_back(entry);
+	return entry.program;
+}
+
+int ProgramCache::reload(GLContext& gl) {
+	int rebuilt = 0;
+	for (auto& entry : entries) {
+		// File times are only precise to the second on some systems, so a second save right after a
+		// reload would go unnoticed. The sources are small, comparing their hash on every poll is cheap.
+		auto vsSource = readFile(entry.vsFile);
+		auto fsSource = readFile(entry.fsFile);
+		auto hash = sourceHash(vsSource, fsSource);
+		if (hash == entry.hash) continue;
+		entry.hash = hash;
+
+		auto handle = build(gl, entry, vsSource, fsSource);
+		if (!handle) continue;
+
+		// swapped in place, materials keep pointing at the same GLProgram
+		glDeleteProgram(entry.program->handle);
+		entry.program->handle = handle;
+		++rebuilt;
+	}
+
+	if (rebuilt > 0) {
+		gl.currentProgram = nullptr;
+		reloaded += rebuilt;
+	}
+	return rebuilt;
+}
+
+bool ProgramCache::binarySupported() {
+	if (binaryFormats < 0) {
+		binaryFormats = 0;
+		if (GLAD_GL_VERSION_4_1) {
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+		}
+	}
+	return binaryFormats > 0;
+}
+
+GLuint ProgramCache::build(GLContext& gl, const Entry& entry, const std::string& vsSource, const std::string& fsSource) {
+	auto cache = cacheName(entry.vsFile, entry.fsFile);
+	auto handle = loadBinary(cache, entry.hash);
+	if (handle) {
+		++fromBinary;
+		return handle;
+	}
+
+	auto vs = gl.compileShader(GL_VERTEX_SHADER, vsSource, entry.vsFile);
+	if (!vs) return 0;
+	auto fs = gl.compileShader(GL_FRAGMENT_SHADER, fsSource, entry.fsFile);
+	if (!fs) {
+		glDeleteShader(vs);
+		return 0;
+	}
+
+	handle = glCreateProgram();
+	if (binarySupported()) {
+		glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glAttachShader(handle, vs);
+	glAttachShader(handle, fs);
+	glLinkProgram(handle);
+
+	// the program keeps what it needs, the shader objects are not used again
+	glDetachShader(handle, vs);
+	glDetachShader(handle, fs);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
+	int success;
+	glGetProgramiv(handle, GL_LINK_STATUS, &success);
+	if (!success) {
+		int length = 0;
+		glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &length);
+		std::string log(std::max(length, 1), '\0');
+		glGetProgramInfoLog(handle, log.size(), nullptr, &log[0]);
+		error(entry.vsFile + " + " + entry.fsFile + ":\n" + log.c_str());
+		glDeleteProgram(handle);
+		return 0;
+	}
+
+	++compiled;
+	saveBinary(handle, cache, entry.hash);
+	return handle;
+}
+
+GLuint ProgramCache::loadBinary(const std::string& name, std::uint64_t hash) {
+	if (!binarySupported()) return 0;
+
+	MappedFile file;
+	if (!file.open(name) || file.size() < sizeof(Header)) return 0;
+
+	Header header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.sourceHash != hash) return 0;
+	if (file.size() != sizeof(header) + header.length) return 0;
+
+	// a driver update can still turn the binary down, then the program is compiled as usual
+	auto handle = glCreateProgram();
+	glProgramBinary(handle, header.format, file.data() + sizeof(header), header.length);
+	int success;
+	glGetProgramiv(handle, GL_LINK_STATUS, &success);
+	if (!success) {
+		glDeleteProgram(handle);
+		return 0;
+	}
+	return handle;
+}
+
+void ProgramCache::saveBinary(GLuint handle, const std::string& name, std::uint64_t hash) {
+	if (!binarySupported()) return;
+
+	int length = 0;
+	glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	std::vector<unsigned char> binary(length);
+	GLenum format;
+	glGetProgramBinary(handle, length, &length, &format, binary.data());
+
+	Header header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.sourceHash = hash;
+	header.format = format;
+	header.length = length;
+
+	// written under another name first, so a crash never leaves a half written binary behind
+	auto temp = name + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return;
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)binary.data(), length);
+		if (!file.good()) {
+			file.close();
+			std::remove(temp.c_str());
+			return;
+		}
+	}
+	std::remove(name.c_str());
+	std::rename(temp.c_str(), name.c_str());
+}
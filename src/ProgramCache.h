@@ -0,0 +1,49 @@
+#ifndef ProgramCache_h
+#define ProgramCache_h
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GLContext;
+class GLProgram;
+
+// Programs by the pair of files they are built from, so asking for the same pair again returns
+// the same program. Where the driver supports program binaries, linked programs are saved next to
+// their vertex shader and loaded back on later launches as long as the sources still hash the same.
+// reload() rebuilds programs whose sources changed on disk and swaps them into the same GLProgram.
+// Programs live until the process exits, like the rest of the GL objects.
+class ProgramCache {
+public:
+	GLProgram* get(GLContext& gl, const std::string& vsFile, const std::string& fsFile);
+	// returns how many programs were rebuilt, a program that fails to build keeps its old version
+	int reload(GLContext& gl);
+
+	// assets/vs.glsl and assets/fs.glsl are cached in assets/vs+fs.cache
+	static std::string cacheName(const std::string& vsFile, const std::string& fsFile);
+
+	int size() const { return entries.size(); }
+	int fromBinary = 0;
+	int compiled = 0;
+	int reloaded = 0;
+
+private:
+	struct Entry {
+		std::string vsFile;
+		std::string fsFile;
+		std::uint64_t hash;
+		GLProgram* program;
+	};
+
+	bool binarySupported();
+	GLuint build(GLContext& gl, const Entry& entry, const std::string& vsSource, const std::string& fsSource);
+	GLuint loadBinary(const std::string& name, std::uint64_t hash);
+	void saveBinary(GLuint handle, const std::string& name, std::uint64_t hash);
+
+	std::vector<Entry> entries;
+	int binaryFormats = -1;
+};
+
+#endif
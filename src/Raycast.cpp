@@ -0,0 +1,116 @@
+#include "Raycast.h"
+
+#include <cmath>
+
+Chunk* getChunk(int gridx, int gridy, int gridz);
+
+bool raycast(const Vector3& origin, const Vector3& direction, float maxDistance, RaycastHit& hit) {
+	hit.hit = false;
+
+	Vector3 dir(direction);
+	if (dir.lengthSq() == 0) return false;
+	dir.normalize();
+
+	int x = (int)floorf(origin.x);
+	int y = (int)floorf(origin.y);
+	int z = (int)floorf(origin.z);
+
+	int stepX = dir.x > 0 ? 1 : (dir.x < 0 ? -1 : 0);
+	int stepY = dir.y > 0 ? 1 : (dir.y < 0 ? -1 : 0);
+	int stepZ = dir.z > 0 ? 1 : (dir.z < 0 ? -1 : 0);
+
+	// distance along the ray to cross one cell on each axis
+	float deltaX = stepX ? fabsf(1.0f / dir.x) : INFINITY;
+	float deltaY = stepY ? fabsf(1.0f / dir.y) : INFINITY;
+	float deltaZ = stepZ ? fabsf(1.0f / dir.z) : INFINITY;
+
+	// distance along the ray to the next cell boundary on each axis
+	float maxX = stepX > 0 ? (x + 1 - origin.x) * deltaX : (stepX < 0 ? (origin.x - x) * deltaX : INFINITY);
+	float maxY = stepY > 0 ? (y + 1 - origin.y) * deltaY : (stepY < 0 ? (origin.y - y) * deltaY : INFINITY);
+	float maxZ = stepZ > 0 ? (z + 1 - origin.z) * deltaZ : (stepZ < 0 ? (origin.z - z) * deltaZ : INFINITY);
+
+	int cx = chunkOf(x);
+	int cy = chunkOf(y);
+	int cz = chunkOf(z);
+	int lx = x & chunkMask;
+	int ly = y & chunkMask;
+	int lz = z & chunkMask;
+	Chunk* chunk = getChunk(cx, cy, cz);
+
+	int nx = 0, ny = 0, nz = 0;
+	float t = 0;
+
+	for (;;) {
+		if (chunk) {
+			auto block = chunk->getBlockAt(lx, ly, lz);
+			if (isSolid(block, false)) {
+				hit.hit = true;
+				hit.block = block;
+				hit.distance = t;
+				hit.x = x;
+				hit.y = y;
+				hit.z = z;
+				hit.nx = nx;
+				hit.ny = ny;
+				hit.nz = nz;
+				hit.px = x + nx;
+				hit.py = y + ny;
+				hit.pz = z + nz;
+				return true;
+			}
+		}
+
+		// step into the neighbouring cell, only looking up a new chunk when crossing its border
+		if (maxX < maxY && maxX < maxZ) {
+			t = maxX;
+			if (t > maxDistance) break;
+			maxX += deltaX;
+			x += stepX;
+			lx += stepX;
+			nx = -stepX; ny = 0; nz = 0;
+			if (lx < 0 || lx >= chunkSize) {
+				cx += stepX;
+				lx -= stepX * chunkSize;
+				chunk = getChunk(cx, cy, cz);
+			}
+		}
+		else if (maxY < maxZ) {
+			t = maxY;
+			if (t > maxDistance) break;
+			maxY += deltaY;
+			y += stepY;
+			ly += stepY;
+			nx = 0; ny = -stepY; nz = 0;
+			if (ly < 0 || ly >= chunkSize) {
+				cy += stepY;
+				ly -= stepY * chunkSize;
+				chunk = getChunk(cx, cy, cz);
+			}
+		}
+		else {
+			t = maxZ;
+			if (t > maxDistance) break;
+			maxZ += deltaZ;
+			z += stepZ;
+			lz += stepZ;
+			nx = 0; ny = 0; nz = -stepZ;
+			if (lz < 0 || lz >= chunkSize) {
+				cz += stepZ;
+				lz -= stepZ * chunkSize;
+				chunk = getChunk(cx, cy, cz);
+			}
+		}
+	}
+
+	return false;
+}
+
+int raycastBatch(const Vector3* origins, const Vector3* directions, int count, float maxDistance, RaycastHit* hits) {
+	int numHits = 0;
+	for (int i = 0; i < count; ++i) {
+		if (raycast(origins[i], directions[i], maxDistance, hits[i])) {
+			++numHits;
+		}
+	}
+	return numHits;
+}
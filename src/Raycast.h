@@ -0,0 +1,34 @@
+#ifndef Raycast_h
+#define Raycast_h
+
+#include "lina.h"
+#include "Chunk.h"
+
+struct RaycastHit {
+	bool hit;
+	BlockType block;
+	float distance;
+
+	// the block that was hit
+	int x;
+	int y;
+	int z;
+
+	// normal of the face the ray entered through
+	int nx;
+	int ny;
+	int nz;
+
+	// the empty cell in front of the hit face
+	int px;
+	int py;
+	int pz;
+};
+
+// Walks the voxel grid along the ray (Amanatides & Woo) and stops at the first solid block.
+bool raycast(const Vector3& origin, const Vector3& direction, float maxDistance, RaycastHit& hit);
+
+// Casts many rays at once, returns the number of rays that hit something.
+int raycastBatch(const Vector3* origins, const Vector3* directions, int count, float maxDistance, RaycastHit* hits);
+
+#endif
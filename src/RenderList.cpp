@@ -0,0 +1,39 @@
+#include "RenderList.h"
+#include "Model.h"
+#include "Material.h"
+
+void RenderList::add(Model* model) {
+	if (model->renderSlot >= 0) return;
+
+	model->renderGroup = groupOf(model);
+	auto& group = groups[model->renderGroup];
+	model->renderSlot = group.size();
+	group.push_back(model);
+}
+
+void RenderList::remove(Model* model) {
+	if (model->renderSlot < 0) return;
+
+	auto& group = groups[model->renderGroup];
+	auto last = group.back();
+	group[model->renderSlot] = last;
+	last->renderSlot = model->renderSlot;
+	group.pop_back();
+
+	model->renderSlot = -1;
+	model->renderGroup = -1;
+}
+
+size_t RenderList::size() const {
+	size_t count = 0;
+	for (auto& group : groups) {
+		count += group.size();
+	}
+	return count;
+}
+
+int RenderList::groupOf(const Model* model) {
+	if (!model->material->depthTest) return 2;
+	if (model->material->alpha) return 1;
+	return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef RenderList_h
+#define RenderList_h
+
+#include <cstddef>
+#include <vector>
+
+class Model;
+
+// Models to draw, grouped in the order they have to be drawn: opaque, transparent, then the
+// ones drawn over everything. Every model remembers its own slot, so removing one swaps the
+// last model of its group into its place instead of searching and shifting the whole list.
+class RenderList {
+public:
+	void add(Model* model);
+	void remove(Model* model);
+
+	size_t size() const;
+
+	static const int numGroups = 3;
+	std::vector<Model*> groups[numGroups];
+
+private:
+	static int groupOf(const Model* model);
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "TextureCache.h"
+
+#include "stb_image.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+	struct Header {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceHash;
+		std::uint32_t columns;
+		std::uint32_t rows;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t layers;
+		std::uint32_t levels;
+	};
+
+	const char magic[4] = { 'T', 'E', 'X', 'C' };
+	const std::uint32_t version = 1;
+
+	// box filter, the last row or column is repeated for odd sizes
+	void downsample(const unsigned char* src, int width, int height, unsigned char* dst) {
+		int w = std::max(1, width / 2);
+		int h = std::max(1, height / 2);
+		for (int y = 0; y < h; ++y) {
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < w; ++x) {
+				int x0 = std::min(x * 2, width - 1);
+				int x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; ++c) {
+					int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c]
+						+ src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+					dst[(y * w + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	void layout(TextureImage& image) {
+		image.offsets.clear();
+		size_t offset = 0;
+		for (int l = 0; l < image.levels; ++l) {
+			image.offsets.push_back(offset);
+			offset += image.levelSize(l);
+		}
+		image.offsets.push_back(offset);
+	}
+}
+
+TextureImage* TextureCache::load(const std::string& name, int columns, int rows) {
+	MappedFile source;
+	if (!source.open(name)) return nullptr;
+	auto hash = hashBytes(source.data(), source.size());
+
+	auto image = new TextureImage();
+	if (read(*image, name, hash, columns, rows)) {
+		return image;
+	}
+
+	if (!decode(*image, source, columns, rows)) {
+		delete image;
+		return nullptr;
+	}
+	write(*image, name, hash, columns, rows);
+	return image;
+}
+
+std::future<TextureImage*> TextureCache::loadAsync(const std::string& name, int columns, int rows) {
+	return std::async(std::launch::async, [name, columns, rows]() {
+		return load(name, columns, rows);
+	});
+}
+
+bool TextureCache::read(TextureImage& image, const std::string& name, unsigned long long hash, int columns, int rows) {
+	if (!image.file.open(cacheName(name))) return false;
+
+	Header header;
+	if (image.file.size() < sizeof(header)) {
+		image.file.close();
+		return false;
+	}
+	memcpy(&header, image.file.data(), sizeof(header));
+
+	bool valid = memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version
+		&& header.sourceHash == hash && header.columns == (std::uint32_t)columns && header.rows == (std::uint32_t)rows
+		&& header.levels > 0 && header.levels <= 32;
+	if (valid) {
+		image.width = header.width;
+		image.height = header.height;
+		image.layers = header.layers;
+		image.levels = header.levels;
+		layout(image);
+		// a blob cut short by an interrupted write does not count
+		valid = image.file.size() == sizeof(header) + image.offsets.back();
+	}
+	if (!valid) {
+		image.file.close();
+		return false;
+	}
+
+	image.pixels = image.file.data() + sizeof(header);
+	return true;
+}
+
+bool TextureCache::decode(TextureImage& image, const MappedFile& source, int columns, int rows) {
+	int width, height, channels;
+	unsigned char* data = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 4);
+	if (!data) return false;
+
+	image.width = width / columns;
+	image.height = height / rows;
+	image.layers = columns * rows;
+	image.levels = 1;
+	while ((std::max(image.width, image.height) >> image.levels) > 0) {
+		++image.levels;
+	}
+	layout(image);
+	image.decoded.resize(image.offsets.back());
+
+	// Each tile is copied out into a layer of its own. GL wants the bottom row first, so the rows
+	// of every tile are flipped on the way.
+	auto base = image.decoded.data();
+	for (int layer = 0; layer < image.layers; ++layer) {
+		int tx = layer % columns;
+		int ty = layer / columns;
+		for (int y = 0; y < image.height; ++y) {
+			int sy = ty * image.height + image.height - 1 - y;
+			auto src = data + ((size_t)sy * width + tx * image.width) * 4;
+			auto dst = base + ((size_t)layer * image.height + y) * image.width * 4;
+			memcpy(dst, src, image.width * 4);
+		}
+	}
+	stbi_image_free(data);
+
+	// every layer gets its own mip chain, so smaller levels never mix in the neighbouring tiles
+	for (int l = 1; l < image.levels; ++l) {
+		int w = image.levelWidth(l - 1);
+		int h = image.levelHeight(l - 1);
+		size_t srcLayer = (size_t)w * h * 4;
+		size_t dstLayer = (size_t)image.levelWidth(l) * image.levelHeight(l) * 4;
+		for (int layer = 0; layer < image.layers; ++layer) {
+			downsample(base + image.offsets[l - 1] + layer * srcLayer, w, h, base + image.offsets[l] + layer * dstLayer);
+		}
+	}
+
+	image.pixels = base;
+	return true;
+}
+
+void TextureCache::write(const TextureImage& image, const std::string& name, unsigned long long hash, int columns, int rows) {
+	Header header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.sourceHash = hash;
+	header.columns = columns;
+	header.rows = rows;
+	header.width = image.width;
+	header.height = image.height;
+	header.layers = image.layers;
+	header.levels = image.levels;
+
+	// written under another name first, so a crash never leaves a half written blob behind
+	auto cache = cacheName(name);
+	auto temp = cache + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return;
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)image.pixels, image.offsets.back());
+		if (!file.good()) {
+			file.close();
+			std::remove(temp.c_str());
+			return;
+		}
+	}
+	std::remove(cache.c_str());
+	std::rename(temp.c_str(), cache.c_str());
+}
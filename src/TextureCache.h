@@ -0,0 +1,53 @@
+#ifndef TextureCache_h
+#define TextureCache_h
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <future>
+#include <string>
+#include <vector>
+
+// The layers of a texture with their whole mip chain, laid out the way glTexImage3D takes them:
+// level after level, and within a level layer after layer of RGBA rows, bottom row first.
+// The pixels either live in the image or point into the mapped cache file.
+class TextureImage {
+public:
+	int width;
+	int height;
+	int layers;
+	int levels;
+
+	int levelWidth(int level) const { return std::max(1, width >> level); }
+	int levelHeight(int level) const { return std::max(1, height >> level); }
+	size_t levelSize(int level) const { return (size_t)levelWidth(level) * levelHeight(level) * 4 * layers; }
+	const unsigned char* level(int level) const { return pixels + offsets[level]; }
+
+	bool fromCache() const { return file.data() != nullptr; }
+
+	const unsigned char* pixels = nullptr;
+	std::vector<size_t> offsets;
+	std::vector<unsigned char> decoded;
+	MappedFile file;
+};
+
+// Decoding a PNG and building its mips is the slow part of loading a texture, so the result is
+// kept in a blob next to the source, <name>.cache. The blob remembers a hash of the source file
+// and how it was cut into tiles, and is rebuilt when either changes.
+class TextureCache {
+public:
+	// Cuts the image into columns x rows tiles, one layer each, numbered row by row from the top
+	// left. Plain textures are a single tile. nullptr if the source cannot be read or decoded.
+	static TextureImage* load(const std::string& name, int columns, int rows);
+	// the same on a worker thread, only the upload has to happen on the GL thread
+	static std::future<TextureImage*> loadAsync(const std::string& name, int columns, int rows);
+
+	static std::string cacheName(const std::string& name) { return name + ".cache"; }
+
+private:
+	static bool read(TextureImage& image, const std::string& name, unsigned long long hash, int columns, int rows);
+	static bool decode(TextureImage& image, const MappedFile& source, int columns, int rows);
+	static void write(const TextureImage& image, const std::string& name, unsigned long long hash, int columns, int rows);
+};
+
+#endif
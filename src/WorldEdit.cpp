@@ -0,0 +1,175 @@
+#include "WorldEdit.h"
+
+#include <algorithm>
+#include <cstring>
+
+Chunk* getChunk(int gridx, int gridy, int gridz);
+
+static void order(int& a, int& b) {
+	if (a > b) std::swap(a, b);
+}
+
+template<typename RowOp> int WorldEdit::edit(int minx, int miny, int minz, int maxx, int maxy, int maxz, RowOp op) {
+	order(minx, maxx);
+	order(miny, maxy);
+	order(minz, maxz);
+
+	Operation operation;
+	int changed = 0;
+
+	for (int cy = chunkOf(miny); cy <= chunkOf(maxy); ++cy) {
+		for (int cz = chunkOf(minz); cz <= chunkOf(maxz); ++cz) {
+			for (int cx = chunkOf(minx); cx <= chunkOf(maxx); ++cx) {
+				auto chunk = getChunk(cx, cy, cz);
+				if (!chunk || !chunk->blocks) continue;
+
+				int ox = cx * chunkSize, oy = cy * chunkSize, oz = cz * chunkSize;
+				int x0 = std::max(minx, ox) - ox, x1 = std::min(maxx, ox + chunkSize - 1) - ox;
+				int y0 = std::max(miny, oy) - oy, y1 = std::min(maxy, oy + chunkSize - 1) - oy;
+				int z0 = std::max(minz, oz) - oz, z1 = std::min(maxz, oz + chunkSize - 1) - oz;
+				int length = x1 - x0 + 1;
+
+				ChunkDiff diff{ cx, cy, cz };
+				int borders = 0;
+
+				row.resize(length);
+				before.resize(length);
+				for (int y = y0; y <= y1; ++y) {
+					for (int z = z0; z <= z1; ++z) {
+						int start = y * chunkSize*chunkSize + z * chunkSize + x0;
+						chunk->readRow(x0, y, z, length, before.data());
+						row = before;
+						BlockType* span = row.data();
+						op(span, length, ox + x0, oy + y, oz + z);
+						// writing makes the chunk own its blocks, a shared chunk the edit leaves alone stays shared
+						if (memcmp(span, before.data(), length) == 0) continue;
+						chunk->writeRow(x0, y, z, length, span);
+
+						for (int i = 0; i < length; ++i) {
+							if (span[i] == before[i]) continue;
+							++changed;
+							borders |= Chunk::bordersOf(x0 + i, y, z);
+							if (!diff.runs.empty() && diff.runs.back().start + diff.runs.back().length == start + i && diff.runs.back().old == before[i]) {
+								diff.runs.back().length++;
+							}
+							else {
+								diff.runs.push_back(Run{ (unsigned short)(start + i), 1, before[i] });
+							}
+						}
+					}
+				}
+
+				if (!diff.runs.empty()) {
+					chunk->markDirty(borders);
+					operation.chunks.push_back(std::move(diff));
+				}
+			}
+		}
+	}
+
+	if (!operation.chunks.empty()) {
+		history.push_back(std::move(operation));
+		if (history.size() > maxUndo) {
+			history.erase(history.begin());
+		}
+	}
+
+	return changed;
+}
+
+int WorldEdit::fill(int minx, int miny, int minz, int maxx, int maxy, int maxz, BlockType type) {
+	return edit(minx, miny, minz, maxx, maxy, maxz, [&](BlockType* span, int length, int, int, int) {
+		memset(span, (int)type, length);
+	});
+}
+
+int WorldEdit::replace(int minx, int miny, int minz, int maxx, int maxy, int maxz, BlockType from, BlockType to) {
+	return edit(minx, miny, minz, maxx, maxy, maxz, [&](BlockType* span, int length, int, int, int) {
+		for (int i = 0; i < length; ++i) {
+			span[i] = span[i] == from ? to : span[i];
+		}
+	});
+}
+
+Clipboard WorldEdit::copy(int minx, int miny, int minz, int maxx, int maxy, int maxz) {
+	order(minx, maxx);
+	order(miny, maxy);
+	order(minz, maxz);
+
+	Clipboard clipboard;
+	clipboard.sizeX = maxx - minx + 1;
+	clipboard.sizeY = maxy - miny + 1;
+	clipboard.sizeZ = maxz - minz + 1;
+	clipboard.blocks.assign(clipboard.sizeX * clipboard.sizeY * clipboard.sizeZ, BlockType::AIR);
+
+	for (int cy = chunkOf(miny); cy <= chunkOf(maxy); ++cy) {
+		for (int cz = chunkOf(minz); cz <= chunkOf(maxz); ++cz) {
+			for (int cx = chunkOf(minx); cx <= chunkOf(maxx); ++cx) {
+				auto chunk = getChunk(cx, cy, cz);
+				if (!chunk || !chunk->blocks) continue;
+
+				int ox = cx * chunkSize, oy = cy * chunkSize, oz = cz * chunkSize;
+				int x0 = std::max(minx, ox), x1 = std::min(maxx, ox + chunkSize - 1);
+				int y0 = std::max(miny, oy), y1 = std::min(maxy, oy + chunkSize - 1);
+				int z0 = std::max(minz, oz), z1 = std::min(maxz, oz + chunkSize - 1);
+
+				for (int y = y0; y <= y1; ++y) {
+					for (int z = z0; z <= z1; ++z) {
+						BlockType* dst = &clipboard.blocks[((y - miny) * clipboard.sizeZ + (z - minz)) * clipboard.sizeX + (x0 - minx)];
+						chunk->readRow(x0 - ox, y - oy, z - oz, x1 - x0 + 1, dst);
+					}
+				}
+			}
+		}
+	}
+
+	return clipboard;
+}
+
+int WorldEdit::paste(const Clipboard& clipboard, int x, int y, int z, bool skipAir) {
+	if (clipboard.blocks.empty()) return 0;
+
+	return edit(x, y, z, x + clipboard.sizeX - 1, y + clipboard.sizeY - 1, z + clipboard.sizeZ - 1, [&](BlockType* span, int length, int wx, int wy, int wz) {
+		const BlockType* src = &clipboard.blocks[((wy - y) * clipboard.sizeZ + (wz - z)) * clipboard.sizeX + (wx - x)];
+		if (!skipAir) {
+			memcpy(span, src, length * sizeof(BlockType));
+			return;
+		}
+		for (int i = 0; i < length; ++i) {
+			span[i] = src[i] == BlockType::AIR ? span[i] : src[i];
+		}
+	});
+}
+
+bool WorldEdit::undo() {
+	if (history.empty()) return false;
+
+	for (auto& diff : history.back().chunks) {
+		auto chunk = getChunk(diff.x, diff.y, diff.z);
+		if (!chunk || !chunk->blocks) continue;
+
+		int borders = 0;
+		BlockType* blocks = chunk->ownBlocks();
+		for (auto& run : diff.runs) {
+			for (int i = run.start; i < run.start + run.length; ++i) {
+				int x = i % chunkSize, y = i / (chunkSize*chunkSize), z = i / chunkSize % chunkSize;
+				blocks[Chunk::index(x, y, z)] = run.old;
+				borders |= Chunk::bordersOf(x, y, z);
+			}
+		}
+		chunk->markDirty(borders);
+	}
+
+	history.pop_back();
+	return true;
+}
+
+size_t WorldEdit::undoMemory() const {
+	size_t size = 0;
+	for (auto& operation : history) {
+		for (auto& diff : operation.chunks) {
+			size += sizeof(ChunkDiff) + diff.runs.size() * sizeof(Run);
+		}
+	}
+	return size;
+}
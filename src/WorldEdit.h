@@ -0,0 +1,59 @@
+#ifndef WorldEdit_h
+#define WorldEdit_h
+
+#include "Chunk.h"
+
+#include <vector>
+
+// A copied box of blocks, stored y-major like a chunk.
+struct Clipboard {
+	int sizeX = 0;
+	int sizeY = 0;
+	int sizeZ = 0;
+	std::vector<BlockType> blocks;
+};
+
+// Edits whole regions of the world. Every operation walks the region chunk by chunk and
+// row by row, marks each touched chunk dirty once and records an undo step that holds
+// only the blocks that actually changed.
+class WorldEdit {
+public:
+	int fill(int minx, int miny, int minz, int maxx, int maxy, int maxz, BlockType type);
+	int replace(int minx, int miny, int minz, int maxx, int maxy, int maxz, BlockType from, BlockType to);
+	Clipboard copy(int minx, int miny, int minz, int maxx, int maxy, int maxz);
+	int paste(const Clipboard& clipboard, int x, int y, int z, bool skipAir);
+	bool undo();
+
+	int undoSteps() const { return history.size(); }
+	size_t undoMemory() const;
+
+	int maxUndo = 32;
+
+private:
+	// consecutive changed blocks of a chunk that all had the same type before the edit, start
+	// is y * chunkSize*chunkSize + z * chunkSize + x whatever the layout of the chunk's blocks
+	struct Run {
+		unsigned short start;
+		unsigned short length;
+		BlockType old;
+	};
+
+	struct ChunkDiff {
+		int x;
+		int y;
+		int z;
+		std::vector<Run> runs;
+	};
+
+	struct Operation {
+		std::vector<ChunkDiff> chunks;
+	};
+
+	template<typename RowOp> int edit(int minx, int miny, int minz, int maxx, int maxy, int maxz, RowOp op);
+
+	std::vector<Operation> history;
+	std::vector<BlockType> before;
+	std::vector<BlockType> row;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef WorldRandom_h
+#define WorldRandom_h
+
+#include <cstdint>
+
+// Counter based random numbers for world generation. The value only depends on the seed and
+// the block coordinates, so it does not matter in which order or on which thread blocks are
+// generated, and a chunk regenerates exactly the same after being evicted.
+inline std::uint32_t hash3(std::uint32_t seed, int x, int y, int z) {
+	std::uint32_t h = seed;
+	h ^= (std::uint32_t)x * 0x8da6b343u;
+	h ^= (std::uint32_t)y * 0xd8163841u;
+	h ^= (std::uint32_t)z * 0xcb1ab31fu;
+
+	// murmur3 finalizer
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+// uniform in [0, range) without a division, range must be below 65536
+inline std::uint32_t random3(std::uint32_t seed, int x, int y, int z, std::uint32_t range) {
+	return ((hash3(seed, x, y, z) >> 16) * range) >> 16;
+}
+
+// uniform in [0, 1)
+inline float random01(std::uint32_t seed, int x, int y, int z) {
+	return (hash3(seed, x, y, z) >> 8) * (1.0f / 16777216);
+}
+
+#endif
@@ -61,6 +61,19 @@ Vector3 operator/(const Vector3& a, float b);
 Vector3 operator-(const Vector3& a);
 Vector3 cross(const Vector3& a, const Vector3& b);
 
+struct IVec3 {
+public:
+	int x, y, z;
+
+	IVec3() = default;
+	IVec3(int x, int y, int z) : x(x), y(y), z(z) {}
+};
+
+inline IVec3 operator+(const IVec3& a, const IVec3& b) { return IVec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline IVec3 operator-(const IVec3& a, const IVec3& b) { return IVec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline bool operator==(const IVec3& a, const IVec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+inline bool operator!=(const IVec3& a, const IVec3& b) { return !(a == b); }
+
 struct Vector4 {
 public:
 	union {
@@ -18,6 +18,20 @@
 #include "GLDebug.h"
 #include "stb_image.h"
 #include "Graph.h"
+#include "Raycast.h"
+#include "Collider.h"
+#include "Entities.h"
+#include "Explosions.h"
+#include "WorldEdit.h"
+#include "FarTerrain.h"
+#include "ChunkStreamer.h"
+#include "ChunkPool.h"
+#include "RenderList.h"
+#include "BlockAllocator.h"
+#include "ChunkView.h"
+#include "CacheMissCounter.h"
+#include "TextureCache.h"
+#include "GLTexture.h"
 
 #include <vector>
 #include <iostream>
@@ -46,7 +60,8 @@ void error(const std::string& msg) {
 }
 
 auto fogColor = Vector3(0.8, 0.8, 1);
-float fogStart = 50;
+float fogStart = 0;
+float fogEnd = 0;
 GLContext gl;
 Camera* camera = nullptr;
 std::vector<Chunk*> chunks;
@@ -69,15 +84,6 @@ Chunk* getChunk(int gridx, int gridy, int gridz) {
 }
 
 BlockType getBlockAt(int x, int y, int z);
-Vector3 getChunkPos(int x, int y, int z);
-
-Vector3 getChunkPos(int x, int y, int z) {
-	Vector3 result(x / chunkSize, y / chunkSize, z / chunkSize);
-	if (x < 0 && (x % chunkSize) != 0) result.x -= 1;
-	if (y < 0 && (y % chunkSize) != 0) result.y -= 1;
-	if (z < 0 && (z % chunkSize) != 0) result.z -= 1;
-	return result;
-}
 
 Vector3 floor(const Vector3& pos) {
 	return Vector3(floorf(pos.x), floorf(pos.y), floorf(pos.z));
@@ -85,7 +91,7 @@ Vector3 floor(const Vector3& pos) {
 
 Chunk* getChunk(const Vector3& pos) {
 	auto fl = floor(pos);
-	auto cp = getChunkPos(pos.x, pos.y, pos.z);
+	auto cp = chunkOf((int)fl.x, (int)fl.y, (int)fl.z);
 	return getChunk(cp.x, cp.y, cp.z);
 }
 
@@ -95,19 +101,28 @@ BlockType getBlockAt(const Vector3& pos) {
 }
 
 BlockType getBlockAt(int x, int y, int z) {
-	Vector3 cp = getChunkPos(x, y, z);
+	auto cp = chunkOf(x, y, z);
 	auto chunk = getChunk(cp.x, cp.y, cp.z);
 	if (!chunk) return BlockType::AIR;
 
-	return chunk->getBlockAt(x - cp.x*chunkSize, y - cp.y*chunkSize, z - cp.z*chunkSize);
+	return chunk->getBlockAt(x & chunkMask, y & chunkMask, z & chunkMask);
 }
 
 void setBlockAt(int x, int y, int z, BlockType type) {
-	Vector3 cp = getChunkPos(x, y, z);
+	auto cp = chunkOf(x, y, z);
 	auto chunk = getChunk(cp.x, cp.y, cp.z);
 	if (!chunk) return;
 
-	chunk->setBlockAt(x - cp.x*chunkSize, y - cp.y*chunkSize, z - cp.z*chunkSize, type);
+	chunk->setBlockAt(x & chunkMask, y & chunkMask, z & chunkMask, type);
+}
+
+// queues a block for simulation by its chunk
+void activateBlock(int x, int y, int z) {
+	auto cp = chunkOf(x, y, z);
+	auto chunk = getChunk(cp.x, cp.y, cp.z);
+	if (!chunk) return;
+
+	chunk->liveBlocks.push_back(DynamicBlock{ x & chunkMask, y & chunkMask, z & chunkMask, 0 });
 }
 
 double currentTime, dt;
@@ -117,8 +132,127 @@ Vector2 move(0, 0);
 bool forward, backward, left, right, jump, click, rclick, grounded, debugInfo = false, fullScreen = false;
 bool gravity = true;
 bool initPlayer = true;
+float pickDistance = 10;
+float playerRadius = 0.25f;
+float playerHeight = 1.7f;
+VoxelCollider collider;
+EntitySystem entities;
+Explosions explosions;
+BlockType placeBlock = BlockType::DIRT;
+WorldEdit worldEdit;
+Clipboard clipboard;
+bool fillKey, copyKey, pasteKey, undoKey, benchKey;
+// distance from the camera beyond which chunks are meshed at the next level of detail
+float lodDistances[Chunk::maxLod] = { 128, 256, 512 };
+float lodHysteresis = 8;
+// hard limit on loaded chunks, above it the least recently used ones outside the load radius go first,
+// set from the streamer's radii at startup
+int maxChunks = 0;
+int frame = 0;
+int evictedFar = 0;
+int evictedLru = 0;
+FarTerrain farTerrain;
+ChunkStreamer streamer;
+ChunkPool chunkPool;
+// chunks are kept sorted by distance to this chunk, a full sort is only needed when it changes
+int sortx = 0, sorty = 0, sortz = 0;
+bool chunksSorted = false;
+int maxChunksPerFrame = 8;
+// seconds per frame spent generating chunks
+double streamBudget = 0.004;
+// nanoseconds per lookup measured by benchmarkLookups
+double benchFloatNs = 0, benchIntNs = 0, benchBlockNs = 0;
+// the benchmark loops add up their results here, so they cannot be optimized away
+volatile int benchSink = 0;
+// microseconds and cache misses per remesh measured by benchmarkRemesh, misses are -1 without a counter
+double benchRemeshUs = 0;
+long long benchRemeshMisses = -1;
+
+// the float conversion block lookups went through before ChunkCoord, kept to compare against
+static Vector3 floatChunkPos(int x, int y, int z) {
+	Vector3 result(x / chunkSize, y / chunkSize, z / chunkSize);
+	if (x < 0 && (x % chunkSize) != 0) result.x -= 1;
+	if (y < 0 && (y % chunkSize) != 0) result.y -= 1;
+	if (z < 0 && (z % chunkSize) != 0) result.z -= 1;
+	return result;
+}
+
+// times the world to chunk conversion, old and new, and complete getBlockAt calls around the player
+void benchmarkLookups() {
+	const int count = 1 << 20;
+	std::vector<int> coords(count * 3);
+	for (int i = 0; i < count; ++i) {
+		coords[i * 3 + 0] = (int)position.x + rand() % 256 - 128;
+		coords[i * 3 + 1] = (int)position.y + rand() % 256 - 128;
+		coords[i * 3 + 2] = (int)position.z + rand() % 256 - 128;
+	}
+
+	int sink = 0;
+	double start = glfwGetTime();
+	for (int i = 0; i < count; ++i) {
+		int x = coords[i * 3 + 0], y = coords[i * 3 + 1], z = coords[i * 3 + 2];
+		auto cp = floatChunkPos(x, y, z);
+		sink += (int)cp.x + (int)cp.y + (int)cp.z + (x - (int)cp.x*chunkSize) + (y - (int)cp.y*chunkSize) + (z - (int)cp.z*chunkSize);
+	}
+	benchFloatNs = (glfwGetTime() - start) * 1e9 / count;
+
+	start = glfwGetTime();
+	for (int i = 0; i < count; ++i) {
+		int x = coords[i * 3 + 0], y = coords[i * 3 + 1], z = coords[i * 3 + 2];
+		auto cp = chunkOf(x, y, z);
+		sink += cp.x + cp.y + cp.z + (x & chunkMask) + (y & chunkMask) + (z & chunkMask);
+	}
+	benchIntNs = (glfwGetTime() - start) * 1e9 / count;
+
+	start = glfwGetTime();
+	for (int i = 0; i < count; ++i) {
+		sink += (int)getBlockAt(coords[i * 3 + 0], coords[i * 3 + 1], coords[i * 3 + 2]);
+	}
+	benchBlockNs = (glfwGetTime() - start) * 1e9 / count;
+
+	benchSink = sink;
+}
+
+// remeshes the chunks around the player, to compare the block layouts of CHUNK_LAYOUT
+void benchmarkRemesh() {
+	auto center = chunkOf((int)floorf(position.x), (int)floorf(position.y), (int)floorf(position.z));
+	std::vector<Chunk*> near;
+	for (auto chunk : chunks) {
+		// new chunks get their models added by the main loop when they are first meshed
+		if (chunk->isNew || chunk->lod > 0) continue;
+		if (std::abs(chunk->gridx - center.x) > 2 || std::abs(chunk->gridy - center.y) > 2 || std::abs(chunk->gridz - center.z) > 2) continue;
+		near.push_back(chunk);
+	}
+	if (near.empty()) return;
+
+	CacheMissCounter counter;
+	double start = glfwGetTime();
+	counter.start();
+	for (auto chunk : near) {
+		chunk->generateModel();
+	}
+	long long misses = counter.stop();
+	benchRemeshUs = (glfwGetTime() - start) * 1e6 / near.size();
+	benchRemeshMisses = counter.available() ? misses / (long long)near.size() : -1;
+}
 
 void updateChunk(Chunk* chunk) {
+	if (chunk->liveBlocks.empty()) return;
+
+	// reads go through the neighbourhood, live blocks that wandered further away fall back to the world
+	ChunkNeighbours neighbours(chunk);
+	auto localBlockAt = [&](int x, int y, int z) {
+		if (ChunkNeighbours::contains(x, y, z)) return neighbours.getBlockAt(x, y, z);
+		return getBlockAt(x + chunk->gridx*chunkSize, y + chunk->gridy*chunkSize, z + chunk->gridz*chunkSize);
+	};
+	auto loadedAt = [&](int x, int y, int z) {
+		if (ChunkNeighbours::contains(x, y, z)) return neighbours.at(x >> chunkShift, y >> chunkShift, z >> chunkShift) != nullptr;
+		auto ch = chunkOf(x + chunk->gridx*chunkSize, y + chunk->gridy*chunkSize, z + chunk->gridz*chunkSize);
+		return getChunk(ch.x, ch.y, ch.z) != nullptr;
+	};
+	// blocks put back until the chunk below them is loaded
+	std::vector<DynamicBlock> waiting;
+
 	for (int i = 0; i < 10; ++i) {
 		if (!chunk->liveBlocks.empty()) {
 			int i = rand() % chunk->liveBlocks.size();
@@ -127,46 +261,31 @@ void updateChunk(Chunk* chunk) {
 			chunk->liveBlocks.pop_back();
 
 			Vector3 wp(block.x + chunk->gridx*chunkSize, block.y + chunk->gridy*chunkSize, block.z + chunk->gridz*chunkSize);
-			auto type = getBlockAt(wp.x, wp.y, wp.z);
-			if (type == BlockType::WOOD) {
-				if (block.power > 0 && getBlockAt(wp.x, wp.y + 1, wp.z) == BlockType::AIR) {
-					setBlockAt(wp.x, wp.y + 1, wp.z, BlockType::WOOD);
-					chunk->liveBlocks.push_back(DynamicBlock{ block.x, block.y + 1, block.z, block.power - 1 });
-				}
-				if (block.power > 0 && block.power < 5) {
-					for (int dx = -1; dx < 2; ++dx) {
-						for (int dz = -1; dz < 2; ++dz) {
-							if (getBlockAt(wp.x + dx, wp.y, wp.z + dz) == BlockType::AIR) {
-								setBlockAt(wp.x + dx, wp.y, wp.z + dz, BlockType::LEAVES);
-								chunk->liveBlocks.push_back(DynamicBlock{ block.x + dx, block.y, block.z + dz, 1 + rand() % 2 });
-							}
-						}
-					}
-				}
+			auto type = localBlockAt(block.x, block.y, block.z);
+			auto flags = BlockRegistry::get(type).flags;
+			// a missing chunk reads as air, falling or flowing into it would drop the block into the void
+			if ((flags & (BLOCK_GRAVITY | BLOCK_FLUID)) && !loadedAt(block.x, block.y - 1, block.z)) {
+				waiting.push_back(block);
+				continue;
 			}
-			else if (type == BlockType::LEAVES) {
-				if (block.power > 0) {
-					for (int dx = -1; dx < 2; ++dx) {
-						for (int dz = -1; dz < 2; ++dz) {
-							if (getBlockAt(wp.x + dx, wp.y, wp.z + dz) == BlockType::AIR) {
-								setBlockAt(wp.x + dx, wp.y, wp.z + dz, BlockType::LEAVES);
-								chunk->liveBlocks.push_back(DynamicBlock{ block.x + dx, block.y, block.z + dz, block.power - 1 });
-							}
-						}
-					}
+			if (flags & BLOCK_GRAVITY) {
+				if (!isSolid(localBlockAt(block.x, block.y - 1, block.z), false)) {
+					setBlockAt(wp.x, wp.y, wp.z, BlockType::AIR);
+					entities.spawn(EntityType::FALLING_BLOCK, type, Vector3(wp.x + 0.5f, wp.y, wp.z + 0.5f), Vector3::zero);
+					chunk->liveBlocks.push_back(DynamicBlock{ block.x, block.y + 1, block.z, 0 });
 				}
 			}
-			else if (type == BlockType::WATER) {
-				if (getBlockAt(wp.x, wp.y - 1, wp.z) == BlockType::AIR) {
-					setBlockAt(wp.x, wp.y - 1, wp.z, BlockType::WATER);
+			else if (flags & BLOCK_FLUID) {
+				if (localBlockAt(block.x, block.y - 1, block.z) == BlockType::AIR) {
+					setBlockAt(wp.x, wp.y - 1, wp.z, type);
 					setBlockAt(wp.x, wp.y, wp.z, BlockType::AIR);
 					chunk->liveBlocks.push_back(DynamicBlock{ block.x, block.y - 1, block.z, block.power });
 				}
 				else {
 					for (int dx = -1; dx < 2; ++dx) {
 						for (int dz = -1; dz < 2; ++dz) {
-							if (getBlockAt(wp.x + dx, wp.y, wp.z + dz) == BlockType::AIR) {
-								setBlockAt(wp.x + dx, wp.y, wp.z + dz, BlockType::WATER);
+							if (localBlockAt(block.x + dx, block.y, block.z + dz) == BlockType::AIR) {
+								setBlockAt(wp.x + dx, wp.y, wp.z + dz, type);
 								chunk->liveBlocks.push_back(DynamicBlock{ block.x + dx, block.y, block.z + dz, block.power });
 							}
 						}
@@ -175,6 +294,16 @@ void updateChunk(Chunk* chunk) {
 			}
 		}
 	}
+	chunk->liveBlocks.insert(chunk->liveBlocks.end(), waiting.begin(), waiting.end());
+}
+
+// waits for a texture loading in the background and uploads it, nullptr if it failed to load
+GLTexture* finishTexture(std::future<TextureImage*>& loading, GLenum target) {
+	auto image = loading.get();
+	if (!image) return nullptr;
+	auto texture = gl.createTexture(*image, target);
+	delete image;
+	return texture;
 }
 
 #ifdef _WIN32
@@ -182,6 +311,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR cmdLine,
 #else
 int main() {
 #endif
+	// textures are decoded, or read from their cache, while the window and context come up
+	auto guiLoading = TextureCache::loadAsync("assets/gui.png", 1, 1);
+	auto atlasLoading = TextureCache::loadAsync("assets/atlas.png", 16, 16);
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -217,11 +350,25 @@ int main() {
 		return -1;
 	}
 
+	if (!BlockRegistry::load("assets/blocks.txt"))
+	{
+		error("Failed to load assets/blocks.txt");
+		return -1;
+	}
+
+	auto guiTexture = finishTexture(guiLoading, GL_TEXTURE_2D);
+	auto atlasTexture = finishTexture(atlasLoading, GL_TEXTURE_2D_ARRAY);
+	if (!guiTexture || !atlasTexture)
+	{
+		error("Failed to load textures");
+		return -1;
+	}
+
 	gl.enable(GL_DEPTH_TEST);
 	gl.enable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 
-	std::vector<Model*> models;
+	RenderList renderList;
 
 	glViewport(0, 0, gl.width, gl.height);
 
@@ -232,7 +379,7 @@ int main() {
 	camera->rotation = Quaternion::identity;
 	camera->fov = 3.14f / 2.0f;
 	camera->zNear = 0.1f;
-	camera->zFar = 1000.0f;
+	camera->zFar = 4096.0f;
 	camera->isOrthographic = false;
 
 	auto gui = new GUI();
@@ -245,7 +392,7 @@ int main() {
 	gui->material->depthTest = false;
 	gui->material->depthWrite = false;
 	gui->material->program = gl.createProgram("assets/gui_vs.glsl", "assets/gui_fs.glsl");
-	gui->material->textures.push_back(gl.loadTexture("assets/gui.png"));
+	gui->material->textures.push_back(guiTexture);
 
 	GUI::Label* label = new GUI::Label(Vector2(0, 0), "");
 	label->color = Vector4::white;
@@ -269,7 +416,7 @@ int main() {
 	auto chMat = new Material();
 	chMat->alpha = false;
 	chMat->program = gl.createProgram("assets/vs.glsl", "assets/fs.glsl");
-	chMat->textures.push_back(gl.loadTexture("assets/atlas.png"));
+	chMat->textures.push_back(atlasTexture);
 	Chunk::chunkMaterial = chMat;
 
 	auto wMat = new Material();
@@ -278,6 +425,12 @@ int main() {
 	wMat->textures.push_back(chMat->textures[0]);
 	Chunk::waterMaterial = wMat;
 
+	auto entMat = new Material();
+	entMat->alpha = false;
+	entMat->program = gl.createProgram("assets/entity_vs.glsl", "assets/fs.glsl");
+	entMat->textures.push_back(chMat->textures[0]);
+	entities.init(entMat);
+
 	ChunkGenerator gen(glfwGetTime()*10000);
 
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -285,9 +438,23 @@ int main() {
 	glfwSetScrollCallback(window, scroll_callback);
 
 	double lastTick = glfwGetTime();
+	double lastShaderCheck = lastTick;
+	double startupSeconds = lastTick;
 
 	GLDebug::init();
-	models.push_back(GLDebug::lineModel);
+	renderList.add(GLDebug::lineModel);
+	renderList.add(entities.model);
+
+	// The hole is square, the load range a cylinder. The hole has to fit into the largest square of
+	// chunks inside the cylinder, less one chunk as the player can stand anywhere in their own.
+	int loadedSquare = (int)(streamer.radius / std::sqrt(2.0f));
+	farTerrain.innerRadius = (loadedSquare - 1) * chunkSize;
+	farTerrain.init(&gen, Chunk::chunkMaterial);
+
+	// Halfway between the chunks in range and all the chunks kept around them. Any higher and the
+	// cap could never be reached, the unload margin alone would keep the count below it.
+	maxChunks = (streamer.rangeChunks() + streamer.keptChunks()) / 2;
+	renderList.add(farTerrain.model);
 
 	//glfwSwapInterval(0);
 	int numTris = 0;
@@ -308,28 +475,17 @@ int main() {
 
 		processInput(window);
 
+		// shaders edited on disk are picked up without restarting
+		if (currentTime - lastShaderCheck > 0.5) {
+			lastShaderCheck = currentTime;
+			gl.reloadPrograms();
+		}
+
 		gl.clearAll(Vector4(fogColor.r, fogColor.g, fogColor.b, 1.0f), 1.0);
 
 		// raycast block
-		auto p = camera->position;
-		bool hasBlock = false;
-		Vector3 blockPos(0, 0, 0);
-		Vector3 prevBlockPos;
-		for (int i = 0; i < 100; ++i) {
-			p = p + camera->front() * 0.1f;
-			prevBlockPos = blockPos;
-			blockPos = p;
-			auto fl = floor(p);
-			auto ch = getChunkPos(fl.x, fl.y, fl.z);
-			auto chunk = getChunk(ch.x, ch.y, ch.z);
-			if (!chunk) continue;
-			auto block = chunk->getBlockAt(fl.x - ch.x*chunkSize, fl.y - ch.y*chunkSize, fl.z - ch.z*chunkSize);
-			if (block != BlockType::AIR && block != BlockType::WATER) {
-				hasBlock = true;
-				//GLDebug::aabb(fl-Vector3(0.001,0.001,0.001), fl + Vector3(1.002, 1.002, 1.002), Vector4(1,1,1,0.5f));
-				break;
-			}
-		}
+		RaycastHit hit;
+		bool hasBlock = raycast(camera->position, camera->front(), pickDistance, hit);
 
 		// input
 		velocity.z = velocity.x = 0;
@@ -346,55 +502,79 @@ int main() {
 		if (left) velocity = velocity - r * speed;
 		if (right) velocity = velocity + r * speed;
 		if ((grounded || !gravity) && jump) velocity.y = 6;
-		if (click && hasBlock) {
-			auto fl = floor(blockPos);
-			auto ch = getChunkPos(fl.x, fl.y, fl.z);
+		if (click && hasBlock && (BlockRegistry::get(hit.block).flags & BLOCK_EXPLOSIVE)) {
+			explosions.ignite(hit.x, hit.y, hit.z, 2.0f);
+		}
+		else if (click && hasBlock) {
+			auto ch = chunkOf(hit.x, hit.y, hit.z);
+			auto local = blockInChunk(hit.x, hit.y, hit.z);
 			auto chunk = getChunk(ch.x, ch.y, ch.z);
-			chunk->setBlockAt(fl.x - ch.x*chunkSize, fl.y - ch.y*chunkSize, fl.z - ch.z*chunkSize, BlockType::AIR);
+			chunk->setBlockAt(local.x, local.y, local.z, BlockType::AIR);
+			entities.spawn(EntityType::ITEM, hit.block, Vector3(hit.x + 0.5f, hit.y + 0.25f, hit.z + 0.5f), Vector3((rand() % 100 - 50) * 0.02f, 4, (rand() % 100 - 50) * 0.02f));
 			for (int x = -1; x < 2; ++x) {
 				for (int y = -1; y < 2; ++y) {
 					for (int z = -1; z < 2; ++z) {
-						chunk->liveBlocks.push_back(DynamicBlock{ (int)fl.x - (int)ch.x*chunkSize + x, (int)fl.y - (int)ch.y*chunkSize + y, (int)fl.z - (int)ch.z*chunkSize + z,1 });
+						chunk->liveBlocks.push_back(DynamicBlock{ local.x + x, local.y + y, local.z + z,1 });
 					}
 				}
 			}
 		}
 		if (rclick && hasBlock) {
-			auto fl = floor(prevBlockPos);
-			auto ch = getChunkPos(fl.x, fl.y, fl.z);
-			auto chunk = getChunk(ch.x, ch.y, ch.z);
-			chunk->setBlockAt(fl.x - ch.x*chunkSize, fl.y - ch.y*chunkSize, fl.z - ch.z*chunkSize, BlockType::DIRT);
+			setBlockAt(hit.px, hit.py, hit.pz, placeBlock);
+			activateBlock(hit.px, hit.py, hit.pz);
+		}
+
+		// region editing around the targeted block
+		if (fillKey && hasBlock) {
+			worldEdit.fill(hit.px - 4, hit.py, hit.pz - 4, hit.px + 3, hit.py + 7, hit.pz + 3, placeBlock);
+		}
+		if (copyKey && hasBlock) {
+			clipboard = worldEdit.copy(hit.x - 8, hit.y, hit.z - 8, hit.x + 7, hit.y + 15, hit.z + 7);
+		}
+		if (pasteKey && hasBlock) {
+			worldEdit.paste(clipboard, hit.px - clipboard.sizeX / 2, hit.py, hit.pz - clipboard.sizeZ / 2, true);
+		}
+		if (undoKey) {
+			worldEdit.undo();
+		}
+		if (benchKey) {
+			benchmarkLookups();
+			benchmarkRemesh();
 		}
 
 		auto qp = floor(position);
-		auto cp = getChunkPos(qp.x, qp.y, qp.z);
-
-		// generate missing chunks
-		std::vector<Chunk*> newChunks;
-		for (int y = -5; y < 6; ++y) {
-			for (int x = -5; x < 6; ++x) {
-				for (int z = -5; z < 6; ++z) {
-					int ix = cp.x + x;
-					int iy = cp.y + y;
-					int iz = cp.z + z;
-					if (getChunk(ix, iy, iz)) continue;
-					auto chunk = new Chunk(ix, iy, iz);
-					chunk->generateBlocks(&gen);
-					chunks.push_back(chunk);
-					break;
-				}
-			}
+		auto cp = chunkOf((int)qp.x, (int)qp.y, (int)qp.z);
+
+		// generate the most urgent missing chunks, a few per frame
+		streamer.update(position, camera->front(), velocity);
+		double streamStart = glfwGetTime();
+		int ix, iy, iz;
+		int loaded = 0;
+		for (int i = 0; i < maxChunksPerFrame && glfwGetTime() - streamStart < streamBudget && streamer.next(ix, iy, iz); ++i) {
+			auto chunk = chunkPool.acquire(ix, iy, iz);
+			chunk->generateBlocks(&gen);
+			chunks.push_back(chunk);
+			++loaded;
 		}
 
-		// remove chunks that are too far away
+		auto unload = [&](Chunk* chunk) {
+			if (chunk == lastChunk) lastChunk = nullptr;
+			gen.pending.dropOrigin(chunk->gridx, chunk->gridy, chunk->gridz, gen.neighbourRadius());
+			if (chunk->model) renderList.remove(chunk->model);
+			if (chunk->waterModel) renderList.remove(chunk->waterModel);
+			chunkPool.release(chunk);
+		};
+
+		// remove chunks beyond the unload radius
+		++frame;
 		std::vector<Chunk*> remaining;
 		for (auto& chunk : chunks) {
-			Vector3 pos = Vector3(chunk->gridx, chunk->gridy, chunk->gridz)*chunkSize;
-			if ((pos - position).length() > camera->zFar) {
-				if (chunk == lastChunk) lastChunk = nullptr;
-				if (chunk->model) models.erase(std::remove(models.begin(), models.end(), chunk->model));
-				if (chunk->waterModel) models.erase(std::remove(models.begin(), models.end(), chunk->waterModel));
-				delete chunk;
+			if (streamer.inRange(chunk->gridx, chunk->gridy, chunk->gridz)) {
+				chunk->lastUsed = frame;
+			}
+			if (streamer.shouldUnload(chunk->gridx, chunk->gridy, chunk->gridz)) {
+				unload(chunk);
+				++evictedFar;
 			}
 			else {
 				remaining.push_back(chunk);
@@ -403,40 +583,88 @@ int main() {
 
 		chunks = remaining;
 
+		// over the cap, drop the chunks that have been out of range the longest
+		if (chunks.size() > (size_t)maxChunks) {
+			auto end = std::partition(chunks.begin(), chunks.end(), [&](Chunk* chunk) { return chunk->lastUsed == frame; });
+			int excess = std::min<int>(chunks.size() - maxChunks, chunks.end() - end);
+			std::nth_element(end, end + excess, chunks.end(), [](Chunk* a, Chunk* b) { return a->lastUsed < b->lastUsed; });
+			for (auto it = end; it != end + excess; ++it) {
+				unload(*it);
+				++evictedLru;
+			}
+			chunks.erase(end, end + excess);
+			chunksSorted = false;
+		}
+
+		// chunks just loaded are sorted on their own and merged into the rest
+		auto chunkDistance = [&](const Chunk* chunk) {
+			int dx = chunk->gridx - sortx;
+			int dy = chunk->gridy - sorty;
+			int dz = chunk->gridz - sortz;
+			return dx*dx + dy*dy + dz*dz;
+		};
+		auto closer = [&](const Chunk* a, const Chunk* b) { return chunkDistance(a) < chunkDistance(b); };
+		if (!chunksSorted || cp != ChunkCoord(sortx, sorty, sortz)) {
+			sortx = cp.x;
+			sorty = cp.y;
+			sortz = cp.z;
+			std::sort(chunks.begin(), chunks.end(), closer);
+			chunksSorted = true;
+		}
+		else if (loaded > 0) {
+			auto middle = chunks.end() - loaded;
+			std::sort(middle, chunks.end(), closer);
+			std::inplace_merge(chunks.begin(), middle, chunks.end(), closer);
+		}
+
+		farTerrain.update(position);
+
+		// pick the level of detail of every chunk, a change remeshes the chunk and its neighbours
+		for (auto& chunk : chunks) {
+			Vector3 center = Vector3(chunk->gridx + 0.5f, chunk->gridy + 0.5f, chunk->gridz + 0.5f)*chunkSize;
+			float distance = (center - position).length();
+			int lod = chunk->lod;
+			while (lod < Chunk::maxLod && distance > lodDistances[lod] + lodHysteresis) ++lod;
+			while (lod > 0 && distance < lodDistances[lod - 1] - lodHysteresis) --lod;
+			if (lod != chunk->lod) {
+				chunk->lod = lod;
+				chunk->markDirty(BORDER_ALL);
+			}
+		}
+
 		// generate chunk meshes
 		auto myChunk = getChunk(position);
 		if (myChunk && myChunk->isDirty) {
 			myChunk->generateModel();
 			if (myChunk->isNew) {
-				models.push_back(myChunk->model);
-				models.push_back(myChunk->waterModel);
+				renderList.add(myChunk->model);
+				renderList.add(myChunk->waterModel);
 				myChunk->isNew = false;
 			}
 		}
 
-		std::sort(chunks.begin(), chunks.end(), [&](Chunk* a, Chunk* b) {
-			auto d1 = (Vector3(a->gridx*chunkSize, a->gridy*chunkSize, a->gridz*chunkSize) - camera->position).lengthSq();
-			auto d2 = (Vector3(b->gridx*chunkSize, b->gridy*chunkSize, b->gridz*chunkSize) - camera->position).lengthSq();
-			if (a->isNew) d1 *= 0.01f;
-			if (b->isNew) d2 *= 0.01f;
-			return d1 < d2;
-		});
-		for (auto& chunk : chunks) {
-			if (chunk->isDirty) {
+		// nearest first, chunks that have never been meshed before the ones that changed
+		bool meshed = false;
+		for (int pass = 0; pass < 2 && !meshed; ++pass) {
+			for (auto& chunk : chunks) {
+				if (!chunk->isDirty || chunk->isNew != (pass == 0)) continue;
 				chunk->generateModel();
 				if (chunk->isNew) {
-					models.push_back(chunk->model);
-					models.push_back(chunk->waterModel);
+					renderList.add(chunk->model);
+					renderList.add(chunk->waterModel);
 					chunk->isNew = false;
 				}
-				if (chunk->model->mesh->numVertices > 0) break;
+				if (chunk->model->mesh->numVertices > 0) {
+					meshed = true;
+					break;
+				}
 			}
 		}
 
 		if (initPlayer) {
 			initPlayer = false;
 			for (int y = 300; y > -300; --y) {
-				if (getBlockAt(Vector3(position.x, y, position.z)) != BlockType::AIR) {
+				if (BlockRegistry::get(getBlockAt(Vector3(position.x, y, position.z))).flags & (BLOCK_SOLID | BLOCK_FLUID)) {
 					position.y = y + 1;
 					break;
 				}
@@ -459,10 +687,11 @@ int main() {
 		grounded = false;
 		auto floorBlock = getBlockAt(qp.x, qp.y, qp.z);
 		if (gravity) {
-			if (floorBlock == BlockType::AIR) {
+			auto floorFlags = BlockRegistry::get(floorBlock).flags;
+			if (!(floorFlags & (BLOCK_SOLID | BLOCK_FLUID))) {
 				velocity.y -= 15.81f*dt;
 			}
-			else if (floorBlock == BlockType::WATER) {
+			else if (floorFlags & BLOCK_FLUID) {
 				grounded = true;
 				velocity.y -= 1.5f*dt;
 				if (velocity.y > 2) {
@@ -475,67 +704,55 @@ int main() {
 		}
 
 		auto headBlock = getBlockAt(camera->position);
-		if (headBlock == BlockType::WATER) {
+		if (BlockRegistry::get(headBlock).flags & BLOCK_FLUID) {
 			fogColor = Vector3(0.35, 0.35, 0.55);
-			fogStart = 1;
+			fogStart = 0;
+			fogEnd = 16;
 		}
 		else {
 			fogColor = Vector3(0.9, 0.9, 1);
-			fogStart = 25;
+			// thick only where the far terrain ends, so its edge never shows
+			fogEnd = farTerrain.visibleRadius();
+			fogStart = fogEnd * 0.25f;
 		}
 
-		position = position + velocity * dt;
+		AABB playerBox;
+		playerBox.min = position - Vector3(playerRadius, 0, playerRadius);
+		playerBox.max = position + Vector3(playerRadius, playerHeight, playerRadius);
+		auto collision = collider.move(playerBox, velocity * dt);
+		position = position + collision.moved;
+		if (collision.hitX) velocity.x = 0;
+		if (collision.hitY) velocity.y = 0;
+		if (collision.hitZ) velocity.z = 0;
+		if (collision.grounded) grounded = true;
 		qp = floor(position);
 
-		if (velocity.y < 0) {
-			qp = floor(position);
-			floorBlock = getBlockAt(qp.x, qp.y, qp.z);
-			if (floorBlock != BlockType::AIR && floorBlock != BlockType::WATER) {
-				velocity.y = 0;
-				position.y = qp.y + 1 + 0.001f;
-				grounded = true;
-			}
-		}
-
-		if (velocity.x > 0) {
-			qp = floor(position + Vector3::right*0.25f);
-			floorBlock = getBlockAt(qp.x, qp.y, qp.z);
-			auto qp2 = floor(position);
-			auto floorBlock2 = getBlockAt(qp2.x, qp2.y, qp2.z);
-			if (floorBlock != BlockType::AIR && floorBlock != BlockType::WATER) {
-				velocity.x = 0;
-				position.x = qp.x - 1 + 0.5f + 0.25f - 0.001f;
+		// entities, items close to the player get picked up
+		entities.update(dt, collider);
+		static std::vector<int> nearby;
+		nearby.clear();
+		entities.query(playerBox.min - Vector3(1, 1, 1), playerBox.max + Vector3(1, 1, 1), nearby);
+		nearby.erase(std::remove_if(nearby.begin(), nearby.end(), [](int i) { return entities.type[i] != EntityType::ITEM || entities.age[i] < 0.5f; }), nearby.end());
+		entities.destroyIndices(nearby);
+
+		// falling blocks that came to rest turn back into blocks
+		for (auto& landing : entities.landings) {
+			if (isSolid(getBlockAt(landing.x, landing.y, landing.z), false)) {
+				entities.spawn(EntityType::ITEM, landing.block, Vector3(landing.x + 0.5f, landing.y + 1, landing.z + 0.5f), Vector3::zero);
 			}
-		}
-		else if (velocity.x < 0) {
-			qp = floor(position + Vector3::left*0.25f);
-			floorBlock = getBlockAt(qp.x, qp.y, qp.z);
-			if (floorBlock != BlockType::AIR && floorBlock != BlockType::WATER) {
-				velocity.x = 0;
-				position.x = qp.x + 1 + 0.5f - 0.25f + 0.001f;
+			else {
+				setBlockAt(landing.x, landing.y, landing.z, landing.block);
+				activateBlock(landing.x, landing.y, landing.z);
 			}
 		}
 
-		if (velocity.z > 0) {
-			qp = floor(position + Vector3::backward*0.25f);
-			floorBlock = getBlockAt(qp.x, qp.y, qp.z);
-			if (floorBlock != BlockType::AIR && floorBlock != BlockType::WATER) {
-				velocity.z = 0;
-				position.z = qp.z - 1 + 0.5f + 0.25f - 0.001f;
-			}
-		}
-		else if (velocity.z < 0) {
-			qp = floor(position + Vector3::forward*0.25f);
-			floorBlock = getBlockAt(qp.x, qp.y, qp.z);
-			if (floorBlock != BlockType::AIR && floorBlock != BlockType::WATER) {
-				velocity.z = 0;
-				position.z = qp.z + 1 + 0.5f - 0.25f + 0.001f;
-			}
-		}
+		explosions.update(dt);
 
 		int numActive = 0;
+		int ownedBlocks = 0;
 		for (auto& chunk : chunks) {
 			numActive += chunk->liveBlocks.size();
+			if (chunk->blocks && !chunk->sharedBlocks) ++ownedBlocks;
 		}
 
 		std::stringstream sstr;
@@ -543,7 +760,27 @@ int main() {
 		sstr << "block - X: " << qp.x << " Y: " << qp.y << " Z: " << qp.z << "\n";
 		sstr << "chunk - X: " << cp.x << " Y: " << cp.y << " Z: " << cp.z << "\n";
 		sstr << "Active blocks: " << numActive << "\n";
+		sstr << "Entities: " << entities.count() << "\n";
+		sstr << "Pending blast chunks: " << explosions.pendingChunks() << "\n";
+		sstr << "Undo steps: " << worldEdit.undoSteps() << " (" << worldEdit.undoMemory() / 1024 << " KB)\n";
+		sstr << "Cached columns: " << gen.columns.size() << " (" << (long long)gen.columns.hits * 100 / std::max(1, gen.columns.hits + gen.columns.misses) << "% hits)\n";
+		sstr << "Chunks: " << chunks.size() << " / " << maxChunks << " (" << ownedBlocks * chunkSize*chunkSize*chunkSize / 1024 << " KB blocks)\n";
+		sstr << "Chunk pool: " << chunkPool.freeChunks() << " free, " << chunkPool.reused << " reused, " << BlockAllocator::instance().slabs() << " slabs\n";
+		sstr << "Evicted: " << evictedFar << " far, " << evictedLru << " lru\n";
+		sstr << "Stream queue: " << streamer.queued() << " (" << streamer.cancelled << " cancelled)\n";
+		sstr << "Pending structure blocks: " << gen.pending.size() << "\n";
+		sstr << "Generation per run:\n";
+		for (auto stage : gen.stages) {
+			sstr << "  " << stage->name << ": " << (int)stage->stats.averageMicroseconds() << " us\n";
+		}
+		sstr << "Lookup (B): " << benchFloatNs << " ns float, " << benchIntNs << " ns int, " << benchBlockNs << " ns getBlockAt\n";
+		sstr << "Remesh (B, " << Chunk::layoutName() << " layout): " << (int)benchRemeshUs << " us, ";
+		if (benchRemeshMisses >= 0) sstr << benchRemeshMisses << " cache misses\n";
+		else sstr << "no cache miss counter\n";
 		sstr << "Chunk hit ratio: " << ((long long)hits * 100 / (hits + misses)) << "%\n";
+		sstr << "Models: " << renderList.size() << "\n";
+		sstr << "Programs: " << gl.programs.size() << " (" << gl.programs.fromBinary << " from binaries, " << gl.programs.compiled << " compiled, " << gl.programs.reloaded << " reloaded)\n";
+		sstr << "Startup: " << (int)(startupSeconds * 1000) << " ms\n";
 		sstr << "Num Tris: " << numTris << "\n";
 
 		label->text = sstr.str();
@@ -562,20 +799,11 @@ int main() {
 		auto lightColor = Vector3(1.0f, 1.0f, 1.0f);
 
 		GLDebug::buildMesh();
-
-		std::sort(models.begin(), models.end(), [&](const Model* a, const Model* b) {
-			int ia = 1;
-			if (a->material->alpha) ia *= 100000;
-			if (!a->material->depthTest) ia *= 100000;
-			int ib = 1;
-			if (b->material->alpha) ib *= 100000;
-			if (!b->material->depthTest) ib *= 100000;
-			return ia < ib;
-		});
+		entities.buildInstances();
 
 		numTris = 0;
 		// models
-		for (auto& model : models) {
+		for (auto& group : renderList.groups) for (auto& model : group) {
 			model->fade -= dt;
 			if (model->fade < 0) model->fade = 0;
 			if (model->mesh->numVertices == 0) continue;
@@ -589,6 +817,7 @@ int main() {
 			model->material->program->setUniform("lightColor", lightColor);
 			model->material->program->setUniform("fogColor", fogColor);
 			model->material->program->setUniform("fogStart", fogStart);
+			model->material->program->setUniform("fogEnd", fogEnd);
 			model->material->program->setUniform("fade", model->fade);
 			model->material->program->setUniform("time", (float)glfwGetTime());
 
@@ -623,6 +852,8 @@ int main() {
 		glfwPollEvents();
 	}
 
+	chunkPool.clear();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -631,12 +862,27 @@ int main() {
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
+bool keyPressed(GLFWwindow* window, int key)
+{
+	static bool wasDown[GLFW_KEY_LAST + 1];
+	bool down = glfwGetKey(window, key) == GLFW_PRESS;
+	bool pressed = down && !wasDown[key];
+	wasDown[key] = down;
+	return pressed;
+}
+
 void processInput(GLFWwindow *window)
 {
 	static bool oldlmousedown;
 	static bool oldrmousedown;
 	forward = backward = left = right = click = rclick = jump = false;
 
+	fillKey = keyPressed(window, GLFW_KEY_F);
+	copyKey = keyPressed(window, GLFW_KEY_C);
+	pasteKey = keyPressed(window, GLFW_KEY_V);
+	undoKey = keyPressed(window, GLFW_KEY_Z);
+	benchKey = keyPressed(window, GLFW_KEY_B);
+
 	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
 		glfwSetWindowShouldClose(window, true);
 	}
@@ -665,6 +911,18 @@ void processInput(GLFWwindow *window)
 	if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) {
 		gravity = !gravity;
 	}
+	if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) {
+		placeBlock = BlockType::DIRT;
+	}
+	if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
+		placeBlock = BlockType::SAND;
+	}
+	if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) {
+		placeBlock = BlockType::GRAVEL;
+	}
+	if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) {
+		placeBlock = BlockType::TNT;
+	}
 	if (glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS) {
 		fullScreen = !fullScreen;
 		if (fullScreen) {